@@ -0,0 +1,250 @@
+#include <algorithm>
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "aabb_tree.hpp"
+
+// Half perimeter, the 2D counterpart of the box surface area
+static float get_half_perimeter(Vector2 min, Vector2 max) {
+    return (max.x - min.x) + (max.y - min.y);
+}
+
+DynamicAABBTree::DynamicAABBTree(float margin) {
+    this->margin = margin;
+}
+
+int DynamicAABBTree::allocate_node() {
+    int idx;
+    if (this->free_list != -1) {
+        idx = this->free_list;
+        this->free_list = this->nodes[idx].parent;
+    } else {
+        idx = this->nodes.size();
+        this->nodes.emplace_back();
+    }
+
+    this->nodes[idx] = Node();
+    this->nodes[idx].height = 0;
+    return idx;
+}
+
+void DynamicAABBTree::free_node(int idx) {
+    this->nodes[idx].height = -1;
+    this->nodes[idx].parent = this->free_list;
+    this->free_list = idx;
+}
+
+void DynamicAABBTree::refit(int idx) {
+    Node &node = this->nodes[idx];
+    Node &left = this->nodes[node.left];
+    Node &right = this->nodes[node.right];
+    node.min = Vector2Min(left.min, right.min);
+    node.max = Vector2Max(left.max, right.max);
+    node.height = 1 + std::max(left.height, right.height);
+}
+
+int DynamicAABBTree::create_proxy(int id, Rectangle aabb) {
+    int proxy = this->allocate_node();
+    Node &node = this->nodes[proxy];
+    node.id = id;
+    node.min = {aabb.x - this->margin, aabb.y - this->margin};
+    node.max = {
+        aabb.x + aabb.width + this->margin, aabb.y + aabb.height + this->margin};
+    this->insert_leaf(proxy);
+    return proxy;
+}
+
+void DynamicAABBTree::destroy_proxy(int proxy) {
+    this->remove_leaf(proxy);
+    this->free_node(proxy);
+}
+
+bool DynamicAABBTree::move_proxy(int proxy, Rectangle aabb) {
+    Node &node = this->nodes[proxy];
+    if (node.min.x <= aabb.x && node.min.y <= aabb.y
+        && aabb.x + aabb.width <= node.max.x && aabb.y + aabb.height <= node.max.y) {
+        return false;
+    }
+
+    this->remove_leaf(proxy);
+    node.min = {aabb.x - this->margin, aabb.y - this->margin};
+    node.max = {
+        aabb.x + aabb.width + this->margin, aabb.y + aabb.height + this->margin};
+    this->insert_leaf(proxy);
+    return true;
+}
+
+void DynamicAABBTree::set_proxy_id(int proxy, int id) {
+    this->nodes[proxy].id = id;
+}
+
+void DynamicAABBTree::insert_leaf(int leaf) {
+    if (this->root == -1) {
+        this->root = leaf;
+        this->nodes[leaf].parent = -1;
+        return;
+    }
+
+    // ---------------------------------------------------------------
+    // descend to the sibling which grows the tree the least
+    Vector2 leaf_min = this->nodes[leaf].min;
+    Vector2 leaf_max = this->nodes[leaf].max;
+    int sibling = this->root;
+    while (!this->nodes[sibling].is_leaf()) {
+        Node &node = this->nodes[sibling];
+        float area = get_half_perimeter(node.min, node.max);
+        float combined_area = get_half_perimeter(
+            Vector2Min(node.min, leaf_min), Vector2Max(node.max, leaf_max)
+        );
+
+        // pairing with this node creates a new parent, descending further
+        // grows this node (inherited cost) plus the child it goes into
+        float cost = 2.0 * combined_area;
+        float inherited_cost = 2.0 * (combined_area - area);
+        float child_costs[2];
+        int children[2] = {node.left, node.right};
+        for (int i = 0; i < 2; ++i) {
+            Node &child = this->nodes[children[i]];
+            float child_area = get_half_perimeter(
+                Vector2Min(child.min, leaf_min), Vector2Max(child.max, leaf_max)
+            );
+            if (!child.is_leaf()) {
+                child_area -= get_half_perimeter(child.min, child.max);
+            }
+            child_costs[i] = child_area + inherited_cost;
+        }
+
+        if (cost < child_costs[0] && cost < child_costs[1]) break;
+        sibling = child_costs[0] < child_costs[1] ? children[0] : children[1];
+    }
+
+    // ---------------------------------------------------------------
+    // put a new parent in place of the sibling
+    int old_parent = this->nodes[sibling].parent;
+    int new_parent = this->allocate_node();
+    this->nodes[new_parent].parent = old_parent;
+    this->nodes[new_parent].left = sibling;
+    this->nodes[new_parent].right = leaf;
+    this->nodes[sibling].parent = new_parent;
+    this->nodes[leaf].parent = new_parent;
+    this->refit(new_parent);
+
+    if (old_parent == -1) {
+        this->root = new_parent;
+    } else if (this->nodes[old_parent].left == sibling) {
+        this->nodes[old_parent].left = new_parent;
+    } else {
+        this->nodes[old_parent].right = new_parent;
+    }
+
+    for (int idx = old_parent; idx != -1; idx = this->nodes[idx].parent) {
+        idx = this->balance(idx);
+        this->refit(idx);
+    }
+}
+
+void DynamicAABBTree::remove_leaf(int leaf) {
+    if (leaf == this->root) {
+        this->root = -1;
+        return;
+    }
+
+    int parent = this->nodes[leaf].parent;
+    int grand_parent = this->nodes[parent].parent;
+    int sibling = this->nodes[parent].left == leaf ? this->nodes[parent].right
+                                                   : this->nodes[parent].left;
+    this->free_node(parent);
+
+    this->nodes[sibling].parent = grand_parent;
+    if (grand_parent == -1) {
+        this->root = sibling;
+        return;
+    }
+
+    if (this->nodes[grand_parent].left == parent) {
+        this->nodes[grand_parent].left = sibling;
+    } else {
+        this->nodes[grand_parent].right = sibling;
+    }
+
+    for (int idx = grand_parent; idx != -1; idx = this->nodes[idx].parent) {
+        idx = this->balance(idx);
+        this->refit(idx);
+    }
+}
+
+// If one child of the node is higher than the other by more than 1, the
+// higher child takes the place of the node, and the node takes the lower
+// grandchild. Returns the index of the node now at this place of the tree.
+int DynamicAABBTree::balance(int a_idx) {
+    Node &a = this->nodes[a_idx];
+    if (a.is_leaf() || a.height < 2) return a_idx;
+
+    int b_idx = a.left;
+    int c_idx = a.right;
+    int balance = this->nodes[c_idx].height - this->nodes[b_idx].height;
+    if (balance >= -1 && balance <= 1) return a_idx;
+
+    // the higher child is lifted, the lower one stays under a
+    int up_idx = balance > 1 ? c_idx : b_idx;
+    Node &up = this->nodes[up_idx];
+    int f_idx = up.left;
+    int g_idx = up.right;
+
+    up.left = a_idx;
+    up.parent = a.parent;
+    a.parent = up_idx;
+    if (up.parent == -1) {
+        this->root = up_idx;
+    } else if (this->nodes[up.parent].left == a_idx) {
+        this->nodes[up.parent].left = up_idx;
+    } else {
+        this->nodes[up.parent].right = up_idx;
+    }
+
+    // the higher grandchild stays under the lifted node, the lower one
+    // replaces the lifted node under a
+    int keep_idx = f_idx;
+    int move_idx = g_idx;
+    if (this->nodes[f_idx].height < this->nodes[g_idx].height) {
+        std::swap(keep_idx, move_idx);
+    }
+    up.right = keep_idx;
+    if (up_idx == c_idx) {
+        a.right = move_idx;
+    } else {
+        a.left = move_idx;
+    }
+    this->nodes[move_idx].parent = a_idx;
+
+    this->refit(a_idx);
+    this->refit(up_idx);
+    return up_idx;
+}
+
+int DynamicAABBTree::query(Rectangle aabb, int out_ids[], int max_n_ids) {
+    if (this->root == -1) return 0;
+
+    Vector2 min = {aabb.x, aabb.y};
+    Vector2 max = {aabb.x + aabb.width, aabb.y + aabb.height};
+    int stack[AABB_TREE_STACK_SIZE];
+    int n_stack = 0;
+    stack[n_stack++] = this->root;
+
+    int n = 0;
+    while (n_stack > 0) {
+        Node &node = this->nodes[stack[--n_stack]];
+        if (!is_overlap(node, min, max)) continue;
+
+        if (node.is_leaf()) {
+            if (n == max_n_ids) return n;
+            out_ids[n++] = node.id;
+        } else {
+            stack[n_stack++] = node.left;
+            stack[n_stack++] = node.right;
+        }
+    }
+
+    return n;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+#include "raylib.h"
+
+#define AABB_TREE_STACK_SIZE 128
+
+// Dynamic bounding volume tree over moving items. Every item (proxy) keeps a
+// fat box: its box grown by a margin. While the item stays inside its fat box,
+// moving it doesn't touch the tree. Leaves are inserted next to the sibling
+// which grows the tree the least, and the nodes are kept balanced by rotations.
+class DynamicAABBTree {
+  private:
+    class Node {
+      public:
+        Vector2 min;
+        Vector2 max;
+        // next free node for the free nodes
+        int parent = -1;
+        int left = -1;
+        int right = -1;
+        // 0 for leaves, -1 for free nodes
+        int height = -1;
+        int id = -1;
+
+        bool is_leaf() {
+            return this->left == -1;
+        }
+    };
+
+    float margin;
+    int root = -1;
+    int free_list = -1;
+    std::vector<Node> nodes;
+
+    int allocate_node();
+    void free_node(int idx);
+    void insert_leaf(int leaf);
+    void remove_leaf(int leaf);
+    int balance(int idx);
+    void refit(int idx);
+
+    static bool is_overlap(Node &node, Vector2 min, Vector2 max) {
+        return node.min.x <= max.x && min.x <= node.max.x && node.min.y <= max.y
+               && min.y <= node.max.y;
+    }
+
+  public:
+    DynamicAABBTree() = default;
+    DynamicAABBTree(float margin);
+
+    // Returns the proxy of the new item
+    int create_proxy(int id, Rectangle aabb);
+    void destroy_proxy(int proxy);
+    // Returns true if the item has left its fat box and was reinserted
+    bool move_proxy(int proxy, Rectangle aabb);
+    void set_proxy_id(int proxy, int id);
+
+    // Writes ids of the items whose fat boxes overlap the aabb, returns their
+    // count
+    int query(Rectangle aabb, int out_ids[], int max_n_ids);
+
+    // Calls on_pair(id_a, id_b) once for every pair of items with overlapping
+    // fat boxes
+    template <typename OnPair> void query_pairs(OnPair on_pair) {
+        int stack[AABB_TREE_STACK_SIZE];
+        int n_nodes = this->nodes.size();
+        for (int leaf = 0; leaf < n_nodes; ++leaf) {
+            if (this->nodes[leaf].height != 0) continue;
+
+            Vector2 min = this->nodes[leaf].min;
+            Vector2 max = this->nodes[leaf].max;
+            int n_stack = 0;
+            stack[n_stack++] = this->root;
+            while (n_stack > 0) {
+                int idx = stack[--n_stack];
+                Node &node = this->nodes[idx];
+                if (!is_overlap(node, min, max)) continue;
+
+                if (node.is_leaf()) {
+                    // the pair is reported from the leaf with the smaller index
+                    if (idx > leaf) on_pair(this->nodes[leaf].id, node.id);
+                } else {
+                    stack[n_stack++] = node.left;
+                    stack[n_stack++] = node.right;
+                }
+            }
+        }
+    }
+
+    // Nearest hit t in [0, 1] of the line, FLT_MAX if nothing is hit.
+    // get_t(id) returns the exact hit t of the item with this id.
+    template <typename GetT> float cast_line(Vector2 start, Vector2 end, GetT get_t) {
+        float nearest_t = FLT_MAX;
+        if (this->root == -1) return nearest_t;
+
+        float inv_dx = 1.0 / (end.x - start.x);
+        float inv_dy = 1.0 / (end.y - start.y);
+        int stack[AABB_TREE_STACK_SIZE];
+        int n_stack = 0;
+        stack[n_stack++] = this->root;
+        while (n_stack > 0) {
+            Node &node = this->nodes[stack[--n_stack]];
+            float tx0 = (node.min.x - start.x) * inv_dx;
+            float tx1 = (node.max.x - start.x) * inv_dx;
+            float ty0 = (node.min.y - start.y) * inv_dy;
+            float ty1 = (node.max.y - start.y) * inv_dy;
+            float t_min = std::max(std::min(tx0, tx1), std::min(ty0, ty1));
+            float t_max = std::min(std::max(tx0, tx1), std::max(ty0, ty1));
+            t_min = std::max(t_min, 0.0f);
+            t_max = std::min(t_max, 1.0f);
+            if (!(t_min <= t_max) || t_min >= nearest_t) continue;
+
+            if (node.is_leaf()) {
+                nearest_t = std::min(nearest_t, get_t(node.id));
+            } else {
+                stack[n_stack++] = node.left;
+                stack[n_stack++] = node.right;
+            }
+        }
+
+        return nearest_t;
+    }
+};
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <cfloat>
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "bvh.hpp"
+
+#define BVH_N_BINS 12
+#define BVH_MAX_LEAF_SIZE 2
+// Cost of visiting a node relative to testing one primitive
+#define BVH_TRAVERSAL_COST 0.5
+
+// Half perimeter, the 2D counterpart of the box surface area: the chance
+// that a random line hits a convex shape is proportional to its perimeter.
+static float get_half_perimeter(Vector2 min, Vector2 max) {
+    return (max.x - min.x) + (max.y - min.y);
+}
+
+static Vector2 get_box_center(Rectangle box) {
+    return {box.x + 0.5f * box.width, box.y + 0.5f * box.height};
+}
+
+void BVH::build(Rectangle boxes[], int ids[], int n) {
+    this->nodes.clear();
+    this->ids.assign(ids, ids + n);
+    this->boxes.assign(boxes, boxes + n);
+    if (n > 0) {
+        this->build_node(0, n);
+    }
+}
+
+int BVH::build_node(int first, int count) {
+    int idx = this->nodes.size();
+    this->nodes.push_back({});
+
+    Vector2 min = {FLT_MAX, FLT_MAX};
+    Vector2 max = {-FLT_MAX, -FLT_MAX};
+    Vector2 centers_min = min;
+    Vector2 centers_max = max;
+    for (int i = first; i < first + count; ++i) {
+        Rectangle box = this->boxes[i];
+        min = Vector2Min(min, {box.x, box.y});
+        max = Vector2Max(max, {box.x + box.width, box.y + box.height});
+        centers_min = Vector2Min(centers_min, get_box_center(box));
+        centers_max = Vector2Max(centers_max, get_box_center(box));
+    }
+    this->nodes[idx].min = min;
+    this->nodes[idx].max = max;
+    this->nodes[idx].first = first;
+    this->nodes[idx].count = count;
+
+    // ---------------------------------------------------------------
+    // find the cheapest split by binning the box centers along each axis
+    float leaf_cost = count;
+    float best_cost = FLT_MAX;
+    int best_axis = -1;
+    int best_bin = 0;
+    if (count > BVH_MAX_LEAF_SIZE) {
+        float parent_area = std::max(get_half_perimeter(min, max), EPSILON);
+        for (int axis = 0; axis < 2; ++axis) {
+            float c0 = axis == 0 ? centers_min.x : centers_min.y;
+            float c1 = axis == 0 ? centers_max.x : centers_max.y;
+            if (c1 - c0 < EPSILON) continue;
+
+            int bin_counts[BVH_N_BINS] = {};
+            Vector2 bin_mins[BVH_N_BINS];
+            Vector2 bin_maxs[BVH_N_BINS];
+            for (int b = 0; b < BVH_N_BINS; ++b) {
+                bin_mins[b] = {FLT_MAX, FLT_MAX};
+                bin_maxs[b] = {-FLT_MAX, -FLT_MAX};
+            }
+
+            float scale = BVH_N_BINS / (c1 - c0);
+            for (int i = first; i < first + count; ++i) {
+                Rectangle box = this->boxes[i];
+                Vector2 center = get_box_center(box);
+                float c = axis == 0 ? center.x : center.y;
+                int b = std::min((int)((c - c0) * scale), BVH_N_BINS - 1);
+                ++bin_counts[b];
+                bin_mins[b] = Vector2Min(bin_mins[b], {box.x, box.y});
+                bin_maxs[b] = Vector2Max(
+                    bin_maxs[b], {box.x + box.width, box.y + box.height}
+                );
+            }
+
+            // sweep from the right to get the cost of every right side
+            float right_costs[BVH_N_BINS];
+            Vector2 right_min = {FLT_MAX, FLT_MAX};
+            Vector2 right_max = {-FLT_MAX, -FLT_MAX};
+            int right_count = 0;
+            for (int b = BVH_N_BINS - 1; b > 0; --b) {
+                right_min = Vector2Min(right_min, bin_mins[b]);
+                right_max = Vector2Max(right_max, bin_maxs[b]);
+                right_count += bin_counts[b];
+                right_costs[b] = right_count == 0
+                                     ? 0.0
+                                     : get_half_perimeter(right_min, right_max)
+                                           * right_count;
+            }
+
+            // and from the left, splitting between the bins b - 1 and b
+            Vector2 left_min = {FLT_MAX, FLT_MAX};
+            Vector2 left_max = {-FLT_MAX, -FLT_MAX};
+            int left_count = 0;
+            for (int b = 1; b < BVH_N_BINS; ++b) {
+                left_min = Vector2Min(left_min, bin_mins[b - 1]);
+                left_max = Vector2Max(left_max, bin_maxs[b - 1]);
+                left_count += bin_counts[b - 1];
+                if (left_count == 0 || left_count == count) continue;
+
+                float left_cost = get_half_perimeter(left_min, left_max) * left_count;
+                float cost = BVH_TRAVERSAL_COST
+                             + (left_cost + right_costs[b]) / parent_area;
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_bin = b;
+                }
+            }
+        }
+    }
+
+    if (best_axis == -1 || best_cost >= leaf_cost) {
+        this->nodes[idx].escape = idx + 1;
+        return idx;
+    }
+
+    // ---------------------------------------------------------------
+    // partition the primitives by the chosen split and build the children
+    float c0 = best_axis == 0 ? centers_min.x : centers_min.y;
+    float c1 = best_axis == 0 ? centers_max.x : centers_max.y;
+    float scale = BVH_N_BINS / (c1 - c0);
+    int mid = first;
+    for (int i = first; i < first + count; ++i) {
+        Vector2 center = get_box_center(this->boxes[i]);
+        float c = best_axis == 0 ? center.x : center.y;
+        int b = std::min((int)((c - c0) * scale), BVH_N_BINS - 1);
+        if (b < best_bin) {
+            std::swap(this->boxes[i], this->boxes[mid]);
+            std::swap(this->ids[i], this->ids[mid]);
+            ++mid;
+        }
+    }
+
+    this->nodes[idx].count = 0;
+    this->build_node(first, mid - first);
+    this->build_node(mid, first + count - mid);
+    this->nodes[idx].escape = this->nodes.size();
+    return idx;
+}
+
+int BVH::query(Rectangle aabb, int out_ids[], int max_n_ids) {
+    Vector2 min = {aabb.x, aabb.y};
+    Vector2 max = {aabb.x + aabb.width, aabb.y + aabb.height};
+
+    int n = 0;
+    int i = 0;
+    int n_nodes = this->nodes.size();
+    while (i < n_nodes) {
+        Node &node = this->nodes[i];
+        bool is_overlap = node.min.x <= max.x && min.x <= node.max.x
+                          && node.min.y <= max.y && min.y <= node.max.y;
+        if (!is_overlap) {
+            i = node.escape;
+            continue;
+        }
+
+        for (int j = 0; j < node.count; ++j) {
+            Rectangle box = this->boxes[node.first + j];
+            if (box.x <= max.x && min.x <= box.x + box.width && box.y <= max.y
+                && min.y <= box.y + box.height) {
+                if (n == max_n_ids) return n;
+                out_ids[n++] = this->ids[node.first + j];
+            }
+        }
+        ++i;
+    }
+
+    return n;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+#include "raylib.h"
+
+// Bounding volume hierarchy over static boxes, built once with the binned SAH.
+// Nodes are stored flat in depth-first order: the left child of an internal
+// node is the next node, and every node keeps the index of the node after its
+// subtree. Traversals just walk the array forward and jump over the subtrees
+// they don't enter, without any stack.
+class BVH {
+  private:
+    class Node {
+      public:
+        Vector2 min;
+        Vector2 max;
+        int escape;
+        // Leaf primitives are ids[first, first + count), internal nodes have
+        // zero count
+        int first;
+        int count;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int> ids;
+    std::vector<Rectangle> boxes;
+
+    int build_node(int first, int count);
+
+  public:
+    void build(Rectangle boxes[], int ids[], int n);
+
+    // Writes ids of the boxes overlapping the aabb, returns their count
+    int query(Rectangle aabb, int out_ids[], int max_n_ids);
+
+    // Nearest hit t in [0, 1] of the line, FLT_MAX if nothing is hit.
+    // get_t(id) returns the exact hit t of the primitive with this id; subtrees
+    // whose boxes are entered after the current nearest hit are skipped.
+    template <typename GetT> float cast_line(Vector2 start, Vector2 end, GetT get_t) {
+        float inv_dx = 1.0 / (end.x - start.x);
+        float inv_dy = 1.0 / (end.y - start.y);
+        float nearest_t = FLT_MAX;
+
+        int i = 0;
+        int n_nodes = this->nodes.size();
+        while (i < n_nodes) {
+            Node &node = this->nodes[i];
+            float tx0 = (node.min.x - start.x) * inv_dx;
+            float tx1 = (node.max.x - start.x) * inv_dx;
+            float ty0 = (node.min.y - start.y) * inv_dy;
+            float ty1 = (node.max.y - start.y) * inv_dy;
+            float t_min = std::max(std::min(tx0, tx1), std::min(ty0, ty1));
+            float t_max = std::min(std::max(tx0, tx1), std::max(ty0, ty1));
+            t_min = std::max(t_min, 0.0f);
+            t_max = std::min(t_max, 1.0f);
+
+            if (!(t_min <= t_max) || t_min >= nearest_t) {
+                i = node.escape;
+                continue;
+            }
+
+            for (int j = 0; j < node.count; ++j) {
+                nearest_t = std::min(nearest_t, get_t(this->ids[node.first + j]));
+            }
+            ++i;
+        }
+
+        return nearest_t;
+    }
+};
@@ -1,5 +1,10 @@
 #include <algorithm>
 #include <cfloat>
+#include <stdexcept>
+
+#ifdef __SSE__
+#include <immintrin.h>
+#endif
 
 #include "raylib.h"
 #include "raymath.h"
@@ -22,6 +27,16 @@ Vector2 flip_vec(Vector2 v) {
     return {-v.x, -v.y};
 }
 
+Rectangle get_circle_aabb(Vector2 position, float radius) {
+    return {position.x - radius, position.y - radius, 2.0f * radius, 2.0f * radius};
+}
+
+Rectangle get_line_aabb(Vector2 start, Vector2 end) {
+    Vector2 min = Vector2Min(start, end);
+    Vector2 max = Vector2Max(start, end);
+    return {min.x, min.y, max.x - min.x, max.y - min.y};
+}
+
 static Vector2 get_circle_proj_bound(Vector2 position, float radius, Vector2 axis) {
     axis = Vector2Normalize(axis);
     Vector2 r = Vector2Scale(axis, radius);
@@ -96,6 +111,75 @@ Vector2 get_circle_polygon_mtv(
     return mtv;
 }
 
+ConvexShape get_convex_shape(Vector2 vertices[], int n) {
+    if (n < 3 || n > MAX_N_CONVEX_SHAPE_VERTICES) {
+        throw std::runtime_error("ERROR: Wrong number of convex shape vertices");
+    }
+
+    // keep the same winding as raylib uses for drawing (negative signed area
+    // in the y-down world), then the rotated edges point outwards
+    float area = 0.0;
+    for (int i = 0; i < n; ++i) {
+        Vector2 v0 = vertices[i];
+        Vector2 v1 = vertices[i < n - 1 ? i + 1 : 0];
+        area += v0.x * v1.y - v1.x * v0.y;
+    }
+
+    ConvexShape shape;
+    shape.n = n;
+    for (int i = 0; i < n; ++i) {
+        shape.vertices[i] = vertices[area > 0.0 ? n - 1 - i : i];
+    }
+
+    Vector2 min = shape.vertices[0];
+    Vector2 max = shape.vertices[0];
+    for (int i = 0; i < n; ++i) {
+        Vector2 v0 = shape.vertices[i];
+        Vector2 v1 = shape.vertices[i < n - 1 ? i + 1 : 0];
+        Vector2 axis = Vector2Normalize(rotate_vec_90(Vector2Subtract(v1, v0)));
+        shape.normals[i] = axis;
+        shape.bounds[i] = get_polygon_proj_bound(shape.vertices, n, axis);
+        min = Vector2Min(min, v0);
+        max = Vector2Max(max, v0);
+    }
+    shape.aabb = {min.x, min.y, max.x - min.x, max.y - min.y};
+
+    return shape;
+}
+
+Vector2 get_circle_convex_shape_mtv(
+    Vector2 position, float radius, ConvexShape *shape
+) {
+    Vector2 nearest_vertex = shape->vertices[0];
+    Vector2 min_overlap_axis;
+    float nearest_dist_sqr = FLT_MAX;
+    float min_overlap = FLT_MAX;
+    for (int i = 0; i < shape->n; ++i) {
+        Vector2 axis = shape->normals[i];
+        float k = Vector2DotProduct(position, axis);
+        Vector2 bound1 = {k - radius, k + radius};
+        update_overlap(shape->bounds[i], bound1, axis, &min_overlap_axis, &min_overlap);
+
+        // separated along an edge normal, no need to check anything else
+        if (min_overlap <= 0.0) return Vector2Zero();
+
+        float curr_dist_sqr = Vector2DistanceSqr(shape->vertices[i], position);
+        if (curr_dist_sqr < nearest_dist_sqr) {
+            nearest_dist_sqr = curr_dist_sqr;
+            nearest_vertex = shape->vertices[i];
+        }
+    }
+
+    // the only axis which depends on the circle position
+    Vector2 axis = Vector2Normalize(Vector2Subtract(position, nearest_vertex));
+    Vector2 bound0 = get_polygon_proj_bound(shape->vertices, shape->n, axis);
+    Vector2 bound1 = get_circle_proj_bound(position, radius, axis);
+    update_overlap(bound0, bound1, axis, &min_overlap_axis, &min_overlap);
+
+    min_overlap = std::max(0.0f, min_overlap);
+    return Vector2Scale(min_overlap_axis, min_overlap);
+}
+
 Vector2 get_circle_circle_mtv(
     Vector2 position0, float radius0, Vector2 position1, float radius1
 ) {
@@ -116,13 +200,43 @@ Vector2 get_circle_circle_mtv(
 }
 
 Vector2 get_circle_rect_mtv(Vector2 position, float radius, Rectangle rect) {
-    Vector2 vertices[4] = {
-        {rect.x, rect.y},
-        {rect.x + rect.width, rect.y},
-        {rect.x + rect.width, rect.y + rect.height},
-        {rect.x, rect.y + rect.height},
-    };
-    return get_circle_polygon_mtv(position, radius, vertices, 4);
+    float x0 = rect.x;
+    float y0 = rect.y;
+    float x1 = rect.x + rect.width;
+    float y1 = rect.y + rect.height;
+
+    // closest point of the rect to the circle center
+    Vector2 closest = {
+        std::clamp(position.x, x0, x1), std::clamp(position.y, y0, y1)};
+    Vector2 d = Vector2Subtract(position, closest);
+    float dist_sqr = d.x * d.x + d.y * d.y;
+
+    if (dist_sqr > 0.0) {
+        if (dist_sqr >= radius * radius) return Vector2Zero();
+        float dist = std::sqrt(dist_sqr);
+        return Vector2Scale(d, (radius - dist) / dist);
+    }
+
+    // the center is inside the rect: push out through the nearest side
+    float left = position.x - x0;
+    float right = x1 - position.x;
+    float top = position.y - y0;
+    float bottom = y1 - position.y;
+    float min_x = std::min(left, right);
+    float min_y = std::min(top, bottom);
+    if (min_x < min_y) {
+        return {left < right ? -(left + radius) : right + radius, 0.0};
+    }
+    return {0.0, top < bottom ? -(top + radius) : bottom + radius};
+}
+
+Vector2 get_circle_rects_mtv(Vector2 position, float radius, Rectangle rects[], int n) {
+    Vector2 start = position;
+    for (int i = 0; i < n; ++i) {
+        Vector2 mtv = get_circle_rect_mtv(position, radius, rects[i]);
+        position = Vector2Add(position, mtv);
+    }
+    return Vector2Subtract(position, start);
 }
 
 int get_line_line_intersection(
@@ -244,27 +358,425 @@ int get_line_rect_intersection_nearest(
     return get_line_polygon_intersection_nearest(start, end, vertices, 4, intersection);
 }
 
-RaysFan get_rays_fan(
+// Rays the fan kernels process: the first n rounded up to whole SIMD
+// registers, the rest of the N slots are not touched
+static int get_rays_fan_n_lanes(int n, int max_n) {
+    return std::min((n + 3) & ~3, max_n);
+}
+
+template <int N>
+RaysFan<N> get_rays_fan(
     Vector2 start, int n, float length, float span_angle, float orientation
 ) {
-    n = std::min(n, MAX_N_RAYS_IN_RAYS_FAN);
+    n = std::min(n, N);
+    int n_lanes = get_rays_fan_n_lanes(n, N);
 
-    RaysFan fan;
+    RaysFan<N> fan;
     fan.n = n;
     fan.start = start;
 
-    Vector2 first_ray = Vector2Rotate({length, 0.0}, orientation);
+    float step = n > 1 ? span_angle / (n - 1) : 0.0;
+    float angle = n > 1 ? orientation - 0.5 * span_angle : orientation;
+    float c = std::cos(step);
+    float s = std::sin(step);
+    float x = length * std::cos(angle);
+    float y = length * std::sin(angle);
+
+    int i = 0;
+#ifdef __SSE__
+    if (N >= 4) {
+        float lanes_x[4];
+        float lanes_y[4];
+        for (int lane = 0; lane < 4; ++lane) {
+            lanes_x[lane] = x;
+            lanes_y[lane] = y;
+            float next_x = x * c - y * s;
+            y = x * s + y * c;
+            x = next_x;
+        }
 
-    if (n == 1) {
-        fan.end[0] = {first_ray.x + start.x, first_ray.y + start.y};
-    } else {
-        float step = span_angle / (n - 1);
-        for (int i = 0; i < n; ++i) {
-            float angle = -0.5 * span_angle + i * step;
-            Vector2 ray = Vector2Rotate(first_ray, angle);
-            fan.end[i] = {ray.x + start.x, ray.y + start.y};
+        // rotation by 4 steps, squared twice from the one-step rotation
+        float c2 = c * c - s * s;
+        float s2 = 2.0 * c * s;
+        __m128 c4 = _mm_set1_ps(c2 * c2 - s2 * s2);
+        __m128 s4 = _mm_set1_ps(2.0 * c2 * s2);
+        __m128 start_x = _mm_set1_ps(start.x);
+        __m128 start_y = _mm_set1_ps(start.y);
+        __m128 vx = _mm_loadu_ps(lanes_x);
+        __m128 vy = _mm_loadu_ps(lanes_y);
+        for (; i + 4 <= n_lanes; i += 4) {
+            // pull the accumulated rounding error out of the ray lengths
+            if (i > 0 && i % 32 == 0) {
+                __m128 len = _mm_sqrt_ps(
+                    _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy))
+                );
+                __m128 k = _mm_div_ps(_mm_set1_ps(length), len);
+                vx = _mm_mul_ps(vx, k);
+                vy = _mm_mul_ps(vy, k);
+            }
+
+            _mm_storeu_ps(&fan.dir_x[i], vx);
+            _mm_storeu_ps(&fan.dir_y[i], vy);
+            _mm_storeu_ps(&fan.end_x[i], _mm_add_ps(start_x, vx));
+            _mm_storeu_ps(&fan.end_y[i], _mm_add_ps(start_y, vy));
+
+            __m128 next_x = _mm_sub_ps(_mm_mul_ps(vx, c4), _mm_mul_ps(vy, s4));
+            vy = _mm_add_ps(_mm_mul_ps(vx, s4), _mm_mul_ps(vy, c4));
+            vx = next_x;
         }
+
+        x = _mm_cvtss_f32(vx);
+        y = _mm_cvtss_f32(vy);
+    }
+#endif
+
+    for (; i < n_lanes; ++i) {
+        if (i > 0 && i % 32 == 0) {
+            float k = length / std::sqrt(x * x + y * y);
+            x *= k;
+            y *= k;
+        }
+
+        fan.dir_x[i] = x;
+        fan.dir_y[i] = y;
+        fan.end_x[i] = start.x + x;
+        fan.end_y[i] = start.y + y;
+
+        float next_x = x * c - y * s;
+        y = x * s + y * c;
+        x = next_x;
+    }
+
+    return fan;
+}
+
+template <int N>
+RaysFan<N> get_rays_fan(
+    Vector2 start, float length, float orientation, const RaysFanOffsets<N> &offsets
+) {
+    RaysFan<N> fan;
+    fan.n = N;
+    fan.start = start;
+
+    float x = length * std::cos(orientation);
+    float y = length * std::sin(orientation);
+    for (int i = 0; i < N; ++i) {
+        float c = offsets.cos[i];
+        float s = offsets.sin[i];
+        fan.dir_x[i] = x * c - y * s;
+        fan.dir_y[i] = x * s + y * c;
+        fan.end_x[i] = start.x + fan.dir_x[i];
+        fan.end_y[i] = start.y + fan.dir_y[i];
     }
 
     return fan;
 }
+
+static float get_ray_rect_intersection_t(
+    Vector2 start, float inv_dx, float inv_dy, Rectangle rect
+) {
+    float tx0 = (rect.x - start.x) * inv_dx;
+    float tx1 = (rect.x + rect.width - start.x) * inv_dx;
+    float ty0 = (rect.y - start.y) * inv_dy;
+    float ty1 = (rect.y + rect.height - start.y) * inv_dy;
+    float t_min = std::max(std::min(tx0, tx1), std::min(ty0, ty1));
+    float t_max = std::min(std::max(tx0, tx1), std::max(ty0, ty1));
+    float t = t_min >= 0.0 ? t_min : t_max;
+    return t_min <= t_max && t >= 0.0 && t <= 1.0 ? t : FLT_MAX;
+}
+
+template <int N>
+void get_rays_fan_rects_intersections_nearest(
+    RaysFan<N> *fan, Rectangle rects[], int n_rects, float t[]
+) {
+    Vector2 start = fan->start;
+    int n_lanes = get_rays_fan_n_lanes(fan->n, N);
+    float inv_dx[N];
+    float inv_dy[N];
+    for (int i = 0; i < n_lanes; ++i) {
+        inv_dx[i] = 1.0 / fan->dir_x[i];
+        inv_dy[i] = 1.0 / fan->dir_y[i];
+        t[i] = FLT_MAX;
+    }
+
+    int i = 0;
+#ifdef __SSE__
+    // 4 rays per register, all of them share the fan start, so the rect
+    // offsets are computed once per rect and broadcast to every lane
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0);
+    __m128 no_hit = _mm_set1_ps(FLT_MAX);
+    for (; i + 4 <= n_lanes; i += 4) {
+        __m128 idx = _mm_loadu_ps(&inv_dx[i]);
+        __m128 idy = _mm_loadu_ps(&inv_dy[i]);
+        __m128 nearest = no_hit;
+        for (int j = 0; j < n_rects; ++j) {
+            Rectangle rect = rects[j];
+            __m128 tx0 = _mm_mul_ps(_mm_set1_ps(rect.x - start.x), idx);
+            __m128 tx1 = _mm_mul_ps(_mm_set1_ps(rect.x + rect.width - start.x), idx);
+            __m128 ty0 = _mm_mul_ps(_mm_set1_ps(rect.y - start.y), idy);
+            __m128 ty1 = _mm_mul_ps(_mm_set1_ps(rect.y + rect.height - start.y), idy);
+            __m128 t_min = _mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1));
+            __m128 t_max = _mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1));
+
+            // t = t_min >= 0 ? t_min : t_max
+            __m128 is_outside = _mm_cmpge_ps(t_min, zero);
+            __m128 t_hit = _mm_or_ps(
+                _mm_and_ps(is_outside, t_min), _mm_andnot_ps(is_outside, t_max)
+            );
+            __m128 is_hit = _mm_and_ps(
+                _mm_cmple_ps(t_min, t_max),
+                _mm_and_ps(_mm_cmpge_ps(t_hit, zero), _mm_cmple_ps(t_hit, one))
+            );
+            t_hit = _mm_or_ps(
+                _mm_and_ps(is_hit, t_hit), _mm_andnot_ps(is_hit, no_hit)
+            );
+            nearest = _mm_min_ps(nearest, t_hit);
+        }
+        _mm_storeu_ps(&t[i], nearest);
+    }
+#endif
+
+    for (; i < n_lanes; ++i) {
+        for (int j = 0; j < n_rects; ++j) {
+            float t_hit = get_ray_rect_intersection_t(
+                start, inv_dx[i], inv_dy[i], rects[j]
+            );
+            t[i] = std::min(t[i], t_hit);
+        }
+    }
+}
+
+float get_line_rects_intersection_t(
+    Vector2 start, Vector2 end, Rectangle rects[], int n_rects
+) {
+    float inv_dx = 1.0 / (end.x - start.x);
+    float inv_dy = 1.0 / (end.y - start.y);
+    float t = FLT_MAX;
+    for (int i = 0; i < n_rects; ++i) {
+        t = std::min(t, get_ray_rect_intersection_t(start, inv_dx, inv_dy, rects[i]));
+    }
+    return t;
+}
+
+// Entry t of the line `start + t * d` into the circle, the quadratic is
+// a * t^2 - 2 * b * t + c = 0 with the circle center taken relative to start.
+// If the start is inside the circle, the exit t is returned instead.
+static float get_line_circle_intersection_t(
+    float dx, float dy, float a, float fx, float fy, float radius
+) {
+    if (radius <= 0.0) return FLT_MAX;
+    float b = dx * fx + dy * fy;
+    float c = fx * fx + fy * fy - radius * radius;
+    float disc = b * b - a * c;
+
+    // Misses the circle or the circle is entirely behind the start
+    if (disc < 0.0 || (b < 0.0 && c > 0.0)) return FLT_MAX;
+
+    float sq = std::sqrt(disc);
+    float t = (c > 0.0 ? b - sq : b + sq) / a;
+    return t >= 0.0 && t <= 1.0 ? t : FLT_MAX;
+}
+
+int get_line_circles_intersection_nearest(
+    Vector2 start,
+    Vector2 end,
+    float xs[],
+    float ys[],
+    float radii[],
+    int n_circles,
+    int skip_id,
+    float *t
+) {
+    float dx = end.x - start.x;
+    float dy = end.y - start.y;
+    float a = dx * dx + dy * dy;
+    float nearest_t = FLT_MAX;
+    int nearest_id = -1;
+
+    int i = 0;
+#ifdef __SSE__
+    if (a > 0.0 && n_circles >= 4) {
+        __m128 zero = _mm_setzero_ps();
+        __m128 one = _mm_set1_ps(1.0);
+        __m128 no_hit = _mm_set1_ps(FLT_MAX);
+        __m128 vdx = _mm_set1_ps(dx);
+        __m128 vdy = _mm_set1_ps(dy);
+        __m128 va = _mm_set1_ps(a);
+        __m128 inv_a = _mm_set1_ps(1.0 / a);
+        __m128 skip = _mm_set1_ps(skip_id);
+        __m128 ids = _mm_set_ps(3.0, 2.0, 1.0, 0.0);
+        __m128 best_t = no_hit;
+        __m128 best_ids = _mm_set1_ps(-1.0);
+        for (; i + 4 <= n_circles; i += 4) {
+            __m128 r = _mm_loadu_ps(&radii[i]);
+            __m128 fx = _mm_sub_ps(_mm_loadu_ps(&xs[i]), _mm_set1_ps(start.x));
+            __m128 fy = _mm_sub_ps(_mm_loadu_ps(&ys[i]), _mm_set1_ps(start.y));
+            __m128 b = _mm_add_ps(_mm_mul_ps(vdx, fx), _mm_mul_ps(vdy, fy));
+            __m128 c = _mm_sub_ps(
+                _mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy, fy)), _mm_mul_ps(r, r)
+            );
+            __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(va, c));
+            __m128 is_outside = _mm_cmpgt_ps(c, zero);
+            __m128 is_behind = _mm_and_ps(_mm_cmplt_ps(b, zero), is_outside);
+            __m128 mask = _mm_andnot_ps(
+                is_behind,
+                _mm_and_ps(
+                    _mm_and_ps(_mm_cmpge_ps(disc, zero), _mm_cmpgt_ps(r, zero)),
+                    _mm_cmpneq_ps(ids, skip)
+                )
+            );
+
+            // Square roots are taken only if some lane can be hit at all
+            if (_mm_movemask_ps(mask)) {
+                __m128 sq = _mm_sqrt_ps(_mm_max_ps(disc, zero));
+                __m128 t_enter = _mm_mul_ps(_mm_sub_ps(b, sq), inv_a);
+                __m128 t_exit = _mm_mul_ps(_mm_add_ps(b, sq), inv_a);
+                __m128 t_hit = _mm_or_ps(
+                    _mm_and_ps(is_outside, t_enter), _mm_andnot_ps(is_outside, t_exit)
+                );
+                mask = _mm_and_ps(
+                    mask,
+                    _mm_and_ps(_mm_cmpge_ps(t_hit, zero), _mm_cmple_ps(t_hit, one))
+                );
+                mask = _mm_and_ps(mask, _mm_cmplt_ps(t_hit, best_t));
+                best_t = _mm_or_ps(
+                    _mm_and_ps(mask, t_hit), _mm_andnot_ps(mask, best_t)
+                );
+                best_ids = _mm_or_ps(
+                    _mm_and_ps(mask, ids), _mm_andnot_ps(mask, best_ids)
+                );
+            }
+            ids = _mm_add_ps(ids, _mm_set1_ps(4.0));
+        }
+
+        float lanes_t[4];
+        float lanes_ids[4];
+        _mm_storeu_ps(lanes_t, best_t);
+        _mm_storeu_ps(lanes_ids, best_ids);
+        for (int lane = 0; lane < 4; ++lane) {
+            if (lanes_t[lane] < nearest_t) {
+                nearest_t = lanes_t[lane];
+                nearest_id = lanes_ids[lane];
+            }
+        }
+    }
+#endif
+
+    if (a > 0.0) {
+        for (; i < n_circles; ++i) {
+            if (i == skip_id) continue;
+            float curr_t = get_line_circle_intersection_t(
+                dx, dy, a, xs[i] - start.x, ys[i] - start.y, radii[i]
+            );
+            if (curr_t < nearest_t) {
+                nearest_t = curr_t;
+                nearest_id = i;
+            }
+        }
+    }
+
+    *t = nearest_t;
+    return nearest_id;
+}
+
+template <int N>
+void get_rays_fan_circles_intersections_nearest(
+    RaysFan<N> *fan,
+    float xs[],
+    float ys[],
+    float radii[],
+    int n_circles,
+    int skip_id,
+    float t[],
+    int ids[]
+) {
+    for (int i = 0; i < fan->n; ++i) {
+        Vector2 end = {fan->end_x[i], fan->end_y[i]};
+        ids[i] = get_line_circles_intersection_nearest(
+            fan->start, end, xs, ys, radii, n_circles, skip_id, &t[i]
+        );
+    }
+}
+
+float get_line_convex_shape_intersection_t(
+    Vector2 start, Vector2 end, ConvexShape *shape
+) {
+    Vector2 d = Vector2Subtract(end, start);
+    float t_enter = -FLT_MAX;
+    float t_exit = FLT_MAX;
+    for (int i = 0; i < shape->n; ++i) {
+        Vector2 normal = shape->normals[i];
+        float dist = shape->bounds[i].y - Vector2DotProduct(start, normal);
+        float speed = Vector2DotProduct(d, normal);
+        if (speed == 0.0) {
+            // parallel to the edge and outside of it
+            if (dist < 0.0) return FLT_MAX;
+            continue;
+        }
+
+        float t = dist / speed;
+        if (speed < 0.0) {
+            t_enter = std::max(t_enter, t);
+        } else {
+            t_exit = std::min(t_exit, t);
+        }
+        if (t_enter > t_exit) return FLT_MAX;
+    }
+
+    float t = t_enter >= 0.0 ? t_enter : t_exit;
+    return t >= 0.0 && t <= 1.0 ? t : FLT_MAX;
+}
+
+float get_point_rect_signed_dist(Vector2 point, Rectangle rect) {
+    float half_w = 0.5 * rect.width;
+    float half_h = 0.5 * rect.height;
+    float qx = fabs(point.x - (rect.x + half_w)) - half_w;
+    float qy = fabs(point.y - (rect.y + half_h)) - half_h;
+    float outside_dist = Vector2Length({std::max(qx, 0.0f), std::max(qy, 0.0f)});
+    return outside_dist + std::min(std::max(qx, qy), 0.0f);
+}
+
+float get_point_convex_shape_signed_dist(Vector2 point, ConvexShape *shape) {
+    // inside, the nearest edge is the one with the largest (negative) offset
+    float max_offset = -FLT_MAX;
+    for (int i = 0; i < shape->n; ++i) {
+        float offset = Vector2DotProduct(
+            shape->normals[i], Vector2Subtract(point, shape->vertices[i])
+        );
+        max_offset = std::max(max_offset, offset);
+    }
+    if (max_offset <= 0.0) return max_offset;
+
+    // outside, the distance to the nearest edge segment
+    float min_dist_sqr = FLT_MAX;
+    for (int i = 0; i < shape->n; ++i) {
+        Vector2 v0 = shape->vertices[i];
+        Vector2 edge = Vector2Subtract(shape->vertices[(i + 1) % shape->n], v0);
+        Vector2 to_point = Vector2Subtract(point, v0);
+        float k = Vector2DotProduct(to_point, edge) / Vector2DotProduct(edge, edge);
+        k = std::clamp(k, 0.0f, 1.0f);
+        Vector2 diff = Vector2Subtract(to_point, Vector2Scale(edge, k));
+        min_dist_sqr = std::min(min_dist_sqr, Vector2DotProduct(diff, diff));
+    }
+    return sqrtf(min_dist_sqr);
+}
+
+#define INSTANTIATE_RAYS_FAN_KERNELS(N) \
+    template RaysFan<N> get_rays_fan<N>(Vector2, int, float, float, float); \
+    template RaysFan<N> get_rays_fan<N>( \
+        Vector2, float, float, const RaysFanOffsets<N> & \
+    ); \
+    template void get_rays_fan_rects_intersections_nearest<N>( \
+        RaysFan<N> *, Rectangle[], int, float[] \
+    ); \
+    template void get_rays_fan_circles_intersections_nearest<N>( \
+        RaysFan<N> *, float[], float[], float[], int, int, float[], int[] \
+    );
+
+INSTANTIATE_RAYS_FAN_KERNELS(8)
+INSTANTIATE_RAYS_FAN_KERNELS(16)
+INSTANTIATE_RAYS_FAN_KERNELS(32)
+INSTANTIATE_RAYS_FAN_KERNELS(64)
+INSTANTIATE_RAYS_FAN_KERNELS(128)
+INSTANTIATE_RAYS_FAN_KERNELS(256)
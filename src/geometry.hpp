@@ -2,12 +2,15 @@
 
 #include "raylib.h"
 
-#define MAX_N_RAYS_IN_RAYS_FAN 64
+#define MAX_N_RAYS_IN_RAYS_FAN 256
+#define MAX_N_CONVEX_SHAPE_VERTICES 8
 
 Vector2 get_orientation_vec(float orientation);
 float get_vec_orientation(Vector2 vec);
 Vector2 rotate_vec_90(Vector2 v);
 Vector2 flip_vec(Vector2 v);
+Rectangle get_circle_aabb(Vector2 position, float radius);
+Rectangle get_line_aabb(Vector2 start, Vector2 end);
 Vector2 get_circle_polygon_mtv(
     Vector2 position, float radius, Vector2 vertices[], int n
 );
@@ -15,6 +18,8 @@ Vector2 get_circle_circle_mtv(
     Vector2 position0, float radius0, Vector2 position1, float radius1
 );
 Vector2 get_circle_rect_mtv(Vector2 position, float radius, Rectangle rect);
+// Pushes the circle out of every rect in turn, returns the total translation
+Vector2 get_circle_rects_mtv(Vector2 position, float radius, Rectangle rects[], int n);
 int get_line_line_intersection(
     Vector2 start0, Vector2 end0, Vector2 start1, Vector2 end1, Vector2 *intersection
 );
@@ -31,11 +36,123 @@ int get_line_rect_intersection_nearest(
     Vector2 start, Vector2 end, Rectangle rect, Vector2 *intersection
 );
 
-typedef struct RaysFan {
+// Convex polygon with everything which doesn't depend on the other shape
+// precomputed once: unit outward edge normals and the projection bounds
+// {min, max} of the polygon onto each of them.
+typedef struct ConvexShape {
+    int n;
+    Vector2 vertices[MAX_N_CONVEX_SHAPE_VERTICES];
+    Vector2 normals[MAX_N_CONVEX_SHAPE_VERTICES];
+    Vector2 bounds[MAX_N_CONVEX_SHAPE_VERTICES];
+    Rectangle aabb;
+} ConvexShape;
+ConvexShape get_convex_shape(Vector2 vertices[], int n);
+Vector2 get_circle_convex_shape_mtv(Vector2 position, float radius, ConvexShape *shape);
+// Nearest parametric hit t in [0, 1] of the line (Cyrus-Beck clipping), or
+// FLT_MAX. If the line starts inside the shape, its exit point is reported.
+float get_line_convex_shape_intersection_t(
+    Vector2 start, Vector2 end, ConvexShape *shape
+);
+
+// Signed distance from the point to the obstacle boundary, negative inside
+float get_point_rect_signed_dist(Vector2 point, Rectangle rect);
+float get_point_convex_shape_signed_dist(Vector2 point, ConvexShape *shape);
+
+// Sine and cosine usable in constant expressions, for |x| <= pi
+constexpr float get_constexpr_sin(float x) {
+    double term = x;
+    double sum = x;
+    for (int k = 1; k < 12; ++k) {
+        term *= -(double)x * x / ((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr float get_constexpr_cos(float x) {
+    double term = 1.0;
+    double sum = 1.0;
+    for (int k = 1; k < 12; ++k) {
+        term *= -(double)x * x / ((2 * k - 1) * (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// Fan of N rays. Rays are stored as SoA arrays, so the batched kernels load
+// them directly. Directions are scaled to the ray length: end = start + dir.
+// Only the first n rays are meaningful. The kernels stop at n rounded up to
+// the SIMD width, the slots past it up to N are left unset.
+template <int N> struct RaysFan {
     int n;
     Vector2 start;
-    Vector2 end[MAX_N_RAYS_IN_RAYS_FAN];
-} RaysFan;
-RaysFan get_rays_fan(
+    float dir_x[N];
+    float dir_y[N];
+    float end_x[N];
+    float end_y[N];
+};
+
+// Unit rotations of each ray relative to the fan orientation
+template <int N> struct RaysFanOffsets {
+    float cos[N];
+    float sin[N];
+};
+
+template <int N> constexpr RaysFanOffsets<N> get_rays_fan_offsets(float span_angle) {
+    RaysFanOffsets<N> offsets = {};
+    for (int i = 0; i < N; ++i) {
+        float angle = N > 1 ? -0.5 * span_angle + i * span_angle / (N - 1) : 0.0;
+        offsets.cos[i] = get_constexpr_cos(angle);
+        offsets.sin[i] = get_constexpr_sin(angle);
+    }
+    return offsets;
+}
+
+// Only two sin/cos pairs per fan: successive directions are produced by
+// complex multiplication with the one-step rotation, 4 rays at a time with SSE.
+template <int N>
+RaysFan<N> get_rays_fan(
     Vector2 start, int n, float length, float span_angle, float orientation
 );
+// Fan with the precomputed offsets, a single sin/cos pair for the orientation.
+template <int N>
+RaysFan<N> get_rays_fan(
+    Vector2 start, float length, float orientation, const RaysFanOffsets<N> &offsets
+);
+
+// Nearest parametric hit t in [0, 1] of every fan ray against the rects
+// (slab method, several rays per SIMD register). Rays which hit nothing get
+// FLT_MAX. If a ray starts inside a rect, its exit point is reported.
+template <int N>
+void get_rays_fan_rects_intersections_nearest(
+    RaysFan<N> *fan, Rectangle rects[], int n_rects, float t[]
+);
+float get_line_rects_intersection_t(
+    Vector2 start, Vector2 end, Rectangle rects[], int n_rects
+);
+
+// Nearest entry t in [0, 1] of the line against circles given as SoA arrays
+// (several circles per SIMD register). Circles with a non-positive radius and
+// the circle with `skip_id` are ignored. Returns the index of the hit circle,
+// or -1 and FLT_MAX in `t` if nothing is hit.
+int get_line_circles_intersection_nearest(
+    Vector2 start,
+    Vector2 end,
+    float xs[],
+    float ys[],
+    float radii[],
+    int n_circles,
+    int skip_id,
+    float *t
+);
+template <int N>
+void get_rays_fan_circles_intersections_nearest(
+    RaysFan<N> *fan,
+    float xs[],
+    float ys[],
+    float radii[],
+    int n_circles,
+    int skip_id,
+    float t[],
+    int ids[]
+);
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cmath>
+
+#include "grid.hpp"
+
+SpatialGrid::SpatialGrid(float cell_size, uint32_t n_buckets) {
+    this->cell_size = cell_size;
+    this->bucket_mask = n_buckets - 1;
+    this->bucket_starts.assign(n_buckets + 1, 0);
+}
+
+SpatialGrid::CellRange SpatialGrid::get_cell_range(Rectangle aabb) {
+    return {
+        (int)std::floor(aabb.x / this->cell_size),
+        (int)std::floor(aabb.y / this->cell_size),
+        (int)std::floor((aabb.x + aabb.width) / this->cell_size),
+        (int)std::floor((aabb.y + aabb.height) / this->cell_size)};
+}
+
+uint32_t SpatialGrid::get_bucket(int x, int y) {
+    uint32_t h = ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u);
+    return h & this->bucket_mask;
+}
+
+void SpatialGrid::clear() {
+    this->entries.clear();
+}
+
+void SpatialGrid::insert(int id, Rectangle aabb) {
+    if (id >= (int)this->ranges.size()) {
+        this->ranges.resize(id + 1);
+    }
+
+    CellRange range = this->get_cell_range(aabb);
+    this->ranges[id] = range;
+    for (int y = range.y0; y <= range.y1; ++y) {
+        for (int x = range.x0; x <= range.x1; ++x) {
+            this->entries.push_back({this->get_bucket(x, y), id});
+        }
+    }
+}
+
+void SpatialGrid::build() {
+    // counting sort of the entries by bucket
+    std::fill(this->bucket_starts.begin(), this->bucket_starts.end(), 0);
+    for (Entry &entry : this->entries) {
+        ++this->bucket_starts[entry.bucket + 1];
+    }
+    for (uint32_t i = 1; i < this->bucket_starts.size(); ++i) {
+        this->bucket_starts[i] += this->bucket_starts[i - 1];
+    }
+
+    this->ids.resize(this->entries.size());
+    for (Entry &entry : this->entries) {
+        // bucket_starts[b] is used as the write cursor of the bucket b - 1
+        this->ids[this->bucket_starts[entry.bucket]++] = entry.id;
+    }
+    for (uint32_t i = this->bucket_starts.size() - 1; i > 0; --i) {
+        this->bucket_starts[i] = this->bucket_starts[i - 1];
+    }
+    this->bucket_starts[0] = 0;
+}
+
+int SpatialGrid::query(Rectangle aabb, int out_ids[], int max_n_ids) {
+    if (this->ids.empty()) return 0;
+
+    CellRange range = this->get_cell_range(aabb);
+    int n = 0;
+    for (int y = range.y0; y <= range.y1; ++y) {
+        for (int x = range.x0; x <= range.x1; ++x) {
+            uint32_t bucket = this->get_bucket(x, y);
+            uint32_t end = this->bucket_starts[bucket + 1];
+            for (uint32_t i = this->bucket_starts[bucket]; i < end; ++i) {
+                // a big item can have several cells in one bucket, the sort is
+                // stable, so their entries are adjacent
+                int id = this->ids[i];
+                if (i > this->bucket_starts[bucket] && this->ids[i - 1] == id) continue;
+
+                // the item is reported only from the first cell of its overlap
+                // with the query, this also skips items of the colliding cells
+                CellRange item = this->ranges[id];
+                if (x != std::max(range.x0, item.x0) || y != std::max(range.y0, item.y0)
+                    || item.x1 < range.x0 || item.y1 < range.y0) {
+                    continue;
+                }
+                if (n == max_n_ids) return n;
+                out_ids[n++] = id;
+            }
+        }
+    }
+
+    return n;
+}
+
+void OccupancyGrid::build(
+    Rectangle boxes[], int ids[], int n, float cell_size, int max_n_cells
+) {
+    this->ids.clear();
+    this->cell_starts.clear();
+    this->n_cols = 0;
+    this->n_rows = 0;
+    if (n == 0) return;
+
+    Vector2 min = {FLT_MAX, FLT_MAX};
+    Vector2 max = {-FLT_MAX, -FLT_MAX};
+    for (int i = 0; i < n; ++i) {
+        min.x = std::min(min.x, boxes[i].x);
+        min.y = std::min(min.y, boxes[i].y);
+        max.x = std::max(max.x, boxes[i].x + boxes[i].width);
+        max.y = std::max(max.y, boxes[i].y + boxes[i].height);
+    }
+
+    // the bounds are closed, so the far borders get their own cells
+    this->origin = min;
+    this->cell_size = cell_size;
+    while (true) {
+        this->n_cols = (int)std::floor((max.x - min.x) / this->cell_size) + 1;
+        this->n_rows = (int)std::floor((max.y - min.y) / this->cell_size) + 1;
+        if ((int64_t)this->n_cols * this->n_rows <= max_n_cells) break;
+        this->cell_size *= 2.0;
+    }
+
+    // ---------------------------------------------------------------
+    // two passes over the cell ranges: count the items per cell, then fill
+    int n_cells = this->n_cols * this->n_rows;
+    this->cell_starts.assign(n_cells + 1, 0);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < n; ++i) {
+            Rectangle box = boxes[i];
+            int x0 = (int)((box.x - min.x) / this->cell_size);
+            int y0 = (int)((box.y - min.y) / this->cell_size);
+            int x1 = (int)((box.x + box.width - min.x) / this->cell_size);
+            int y1 = (int)((box.y + box.height - min.y) / this->cell_size);
+            x1 = std::min(x1, this->n_cols - 1);
+            y1 = std::min(y1, this->n_rows - 1);
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    int cell = y * this->n_cols + x;
+                    if (pass == 0) {
+                        ++this->cell_starts[cell + 1];
+                    } else {
+                        // cell_starts[c] is used as the write cursor of the cell c - 1
+                        this->ids[this->cell_starts[cell + 1]++] = ids[i];
+                    }
+                }
+            }
+        }
+
+        if (pass == 0) {
+            for (int c = 1; c <= n_cells; ++c) {
+                this->cell_starts[c] += this->cell_starts[c - 1];
+            }
+            this->ids.resize(this->cell_starts[n_cells]);
+            // shift the starts, so the fill pass can use them as cursors
+            for (int c = n_cells; c > 0; --c) {
+                this->cell_starts[c] = this->cell_starts[c - 1];
+            }
+        }
+    }
+}
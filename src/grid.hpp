@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "raylib.h"
+
+// Uniform grid over the unbounded plane. Cells are hashed into a fixed number
+// of buckets, so the grid needs no world bounds. Items are collected by
+// insert() and sorted into the buckets by build(). An item overlapping several
+// cells is stored in each of them, but a query reports it only once: from the
+// first cell of its overlap with the query. Queries don't modify the grid, so
+// they can run concurrently.
+class SpatialGrid {
+  private:
+    class CellRange {
+      public:
+        int x0;
+        int y0;
+        int x1;
+        int y1;
+    };
+
+    class Entry {
+      public:
+        uint32_t bucket;
+        int id;
+    };
+
+    float cell_size;
+    uint32_t bucket_mask;
+
+    std::vector<Entry> entries;
+    std::vector<CellRange> ranges;
+    std::vector<uint32_t> bucket_starts;
+    std::vector<int> ids;
+
+    CellRange get_cell_range(Rectangle aabb);
+    uint32_t get_bucket(int x, int y);
+
+  public:
+    SpatialGrid() = default;
+    // n_buckets must be a power of two
+    SpatialGrid(float cell_size, uint32_t n_buckets);
+
+    void clear();
+    void insert(int id, Rectangle aabb);
+    void build();
+    // Writes ids of the items whose cells overlap the aabb, returns their count
+    int query(Rectangle aabb, int out_ids[], int max_n_ids);
+};
+
+// Bounded grid over static items, covering their joint bounds. Every cell
+// lists the items overlapping it, so a line is tested only against the items
+// of the cells it crosses. The cells are walked in the line order (Amanatides
+// and Woo DDA), and the walk stops at the first cell which ends after the
+// nearest hit found so far.
+class OccupancyGrid {
+  private:
+    Vector2 origin;
+    float cell_size = 0.0;
+    int n_cols = 0;
+    int n_rows = 0;
+
+    std::vector<uint32_t> cell_starts;
+    std::vector<int> ids;
+
+  public:
+    // The cell size is doubled until the grid has at most max_n_cells cells
+    void build(Rectangle boxes[], int ids[], int n, float cell_size, int max_n_cells);
+
+    // Nearest hit t in [0, 1] of the line, FLT_MAX if nothing is hit.
+    // get_t(id) returns the exact hit t of the item with this id. An item
+    // overlapping several cells may be tested more than once.
+    template <typename GetT> float cast_line(Vector2 start, Vector2 end, GetT get_t) {
+        if (this->ids.empty()) return FLT_MAX;
+
+        // clip the line by the grid bounds
+        float size_x = this->n_cols * this->cell_size;
+        float size_y = this->n_rows * this->cell_size;
+        float dx = end.x - start.x;
+        float dy = end.y - start.y;
+        float t_enter = 0.0;
+        float t_exit = 1.0;
+        float start_axes[2] = {start.x - this->origin.x, start.y - this->origin.y};
+        float dir_axes[2] = {dx, dy};
+        float size_axes[2] = {size_x, size_y};
+        for (int axis = 0; axis < 2; ++axis) {
+            float s = start_axes[axis];
+            float d = dir_axes[axis];
+            if (d == 0.0) {
+                if (s < 0.0 || s > size_axes[axis]) return FLT_MAX;
+                continue;
+            }
+            float t0 = -s / d;
+            float t1 = (size_axes[axis] - s) / d;
+            t_enter = std::max(t_enter, std::min(t0, t1));
+            t_exit = std::min(t_exit, std::max(t0, t1));
+        }
+        if (t_enter > t_exit) return FLT_MAX;
+
+        // ---------------------------------------------------------------
+        // walk the cells from the one containing the clipped line start
+        float px = start_axes[0] + t_enter * dx;
+        float py = start_axes[1] + t_enter * dy;
+        int x = std::clamp((int)(px / this->cell_size), 0, this->n_cols - 1);
+        int y = std::clamp((int)(py / this->cell_size), 0, this->n_rows - 1);
+
+        int step_x = dx > 0.0 ? 1 : -1;
+        int step_y = dy > 0.0 ? 1 : -1;
+        float t_delta_x = dx == 0.0 ? FLT_MAX : this->cell_size / std::fabs(dx);
+        float t_delta_y = dy == 0.0 ? FLT_MAX : this->cell_size / std::fabs(dy);
+        float t_max_x = FLT_MAX;
+        float t_max_y = FLT_MAX;
+        if (dx != 0.0) {
+            float border_x = (x + (dx > 0.0)) * this->cell_size;
+            t_max_x = (border_x - start_axes[0]) / dx;
+        }
+        if (dy != 0.0) {
+            float border_y = (y + (dy > 0.0)) * this->cell_size;
+            t_max_y = (border_y - start_axes[1]) / dy;
+        }
+
+        float nearest_t = FLT_MAX;
+        while (true) {
+            int cell = y * this->n_cols + x;
+            uint32_t cell_end = this->cell_starts[cell + 1];
+            for (uint32_t i = this->cell_starts[cell]; i < cell_end; ++i) {
+                nearest_t = std::min(nearest_t, get_t(this->ids[i]));
+            }
+
+            float t_cell_exit = std::min(t_max_x, t_max_y);
+            if (nearest_t <= t_cell_exit || t_cell_exit >= t_exit) break;
+
+            if (t_max_x < t_max_y) {
+                x += step_x;
+                t_max_x += t_delta_x;
+                if (x < 0 || x >= this->n_cols) break;
+            } else {
+                y += step_y;
+                t_max_y += t_delta_y;
+                if (y < 0 || y >= this->n_rows) break;
+            }
+        }
+
+        return nearest_t;
+    }
+};
@@ -0,0 +1,213 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "replay.hpp"
+#include "world.hpp"
+#include "world_batch.hpp"
+
+#define DEFAULT_N_TICKS 100000
+#define DEFAULT_N_ROLLOUTS 10000
+#define DEFAULT_N_ROLLOUT_TICKS 60
+#define SNAPSHOT_BENCHMARK_N_WARMUP_TICKS 600
+
+// The manual dude spins and shoots, the rest are dummies
+static void spawn_level(World &world) {
+    world.spawn_dude({{0.0, 0.0}, AIType::MANUAL});
+    for (int i = 1; i < MAX_N_DUDES; ++i) {
+        Vector2 position = {10.0f + 3.0f * (i % 4), -6.0f + 3.0f * (i / 4)};
+        world.spawn_dude({position, AIType::DUMMY});
+    }
+    world.spawn_obstacle({{.x = -5.0, .y = 5.0, .width = 10.0, .height = 2.0}});
+    world.spawn_obstacle({{.x = -15.0, .y = 0.0, .width = 3.0, .height = 10.0}});
+    Vector2 pentagon[5] = {
+        {8.0, -6.0}, {11.0, -8.0}, {14.0, -6.0}, {13.0, -3.0}, {9.0, -3.0}};
+    world.spawn_obstacle({pentagon, 5});
+    world.finish_level();
+}
+
+static void act(World &world) {
+    for (Dude &dude : world.dudes) {
+        if (dude.ai_type != AIType::MANUAL) continue;
+        dude.action.orientation = std::fmod(world.time, 2.0f * PI);
+        dude.action.is_shooting = true;
+    }
+}
+
+static double get_seconds_since(std::chrono::steady_clock::time_point start) {
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Forks one warmed up world into many short rollouts by restoring a snapshot.
+// Every rollout starts from the same state, so they all must end the same.
+static int run_snapshot_benchmark(int n_rollouts, int n_rollout_ticks) {
+    World world;
+    spawn_level(world);
+    for (int tick = 0; tick < SNAPSHOT_BENCHMARK_N_WARMUP_TICKS; ++tick) {
+        act(world);
+        world.update();
+    }
+
+    WorldSnapshot snapshot;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_rollouts; ++i) {
+        world.take_snapshot(snapshot);
+    }
+    double take_seconds = get_seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_rollouts; ++i) {
+        world.restore_snapshot(snapshot);
+    }
+    double restore_seconds = get_seconds_since(start);
+
+    bool is_deterministic = true;
+    Vector2 first_end_position = {0.0, 0.0};
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_rollouts; ++i) {
+        world.restore_snapshot(snapshot);
+        for (int tick = 0; tick < n_rollout_ticks; ++tick) {
+            act(world);
+            world.update();
+        }
+
+        Vector2 end_position = {0.0, 0.0};
+        for (Dude &dude : world.dudes) {
+            end_position = Vector2Add(end_position, dude.position);
+        }
+        if (i == 0) first_end_position = end_position;
+        is_deterministic &= end_position.x == first_end_position.x
+                            && end_position.y == first_end_position.y;
+    }
+    double rollout_seconds = get_seconds_since(start);
+
+    printf(
+        "snapshots/sec: %.0f, restores/sec: %.0f\n",
+        n_rollouts / take_seconds,
+        n_rollouts / restore_seconds
+    );
+    printf(
+        "rollouts: %d x %d ticks, rollouts/sec: %.0f, deterministic: %s\n",
+        n_rollouts,
+        n_rollout_ticks,
+        n_rollouts / rollout_seconds,
+        is_deterministic ? "yes" : "no"
+    );
+    return is_deterministic ? 0 : 1;
+}
+
+// Records the headless level into a replay file
+static int run_record(const char *file_path, int n_ticks) {
+    World world;
+    spawn_level(world);
+
+    ReplayRecorder recorder;
+    recorder.begin(world);
+    for (int tick = 0; tick < n_ticks; ++tick) {
+        act(world);
+        recorder.record(world);
+        world.update();
+    }
+    recorder.end(world);
+    recorder.replay.save(file_path);
+
+    printf("ticks: %d, replay bytes: %zu\n", n_ticks, recorder.replay.data.size());
+    return 0;
+}
+
+// Resimulates a replay file, checking the recorded world hashes on the way
+static int run_replay(const char *file_path) {
+    Replay replay;
+    replay.load(file_path);
+
+    World world;
+    ReplayPlayer player(replay);
+    player.begin(world);
+
+    auto start = std::chrono::steady_clock::now();
+    while (player.step(world)) {
+    }
+    double seconds = get_seconds_since(start);
+
+    printf(
+        "ticks: %u, seconds: %.3f, ticks/sec: %.0f, hashes verified\n",
+        player.n_ticks,
+        seconds,
+        player.n_ticks / seconds
+    );
+    return 0;
+}
+
+// Runs the simulation without a window as fast as possible.
+// Usage: crossover_2_headless [n_ticks] [n_worlds] [n_threads]
+// With more than one world, every world runs n_ticks ticks in a WorldBatch.
+// Usage: crossover_2_headless snapshot [n_rollouts] [n_rollout_ticks]
+// Benchmarks forking the world with snapshots.
+// Usage: crossover_2_headless record <file_path> [n_ticks]
+//        crossover_2_headless replay <file_path>
+int main(int argc, char *argv[]) {
+    if (argc > 2 && strcmp(argv[1], "record") == 0) {
+        int n_ticks = argc > 3 ? atoi(argv[3]) : DEFAULT_N_TICKS;
+        return run_record(argv[2], n_ticks);
+    }
+    if (argc > 2 && strcmp(argv[1], "replay") == 0) {
+        return run_replay(argv[2]);
+    }
+    if (argc > 1 && strcmp(argv[1], "snapshot") == 0) {
+        int n_rollouts = argc > 2 ? atoi(argv[2]) : DEFAULT_N_ROLLOUTS;
+        int n_rollout_ticks = argc > 3 ? atoi(argv[3]) : DEFAULT_N_ROLLOUT_TICKS;
+        return run_snapshot_benchmark(n_rollouts, n_rollout_ticks);
+    }
+
+    int n_ticks = argc > 1 ? atoi(argv[1]) : DEFAULT_N_TICKS;
+    int n_worlds = argc > 2 ? atoi(argv[2]) : 1;
+    int n_threads = argc > 3 ? atoi(argv[3]) : 0;
+
+    if (n_worlds > 1) {
+        WorldBatch batch(n_worlds, n_threads);
+        for (World &world : batch.worlds) {
+            spawn_level(world);
+        }
+
+        batch.run(n_ticks, act, nullptr);
+        printf(
+            "worlds: %d, ticks: %lld, seconds: %.3f, ticks/sec: %.0f\n",
+            n_worlds,
+            (long long)batch.n_ticks,
+            batch.seconds,
+            batch.ticks_per_second
+        );
+        return 0;
+    }
+
+    // a single world spreads its dudes over the threads, if they're given
+    World world;
+    std::unique_ptr<ThreadPool> pool;
+    if (argc > 3) {
+        pool = std::make_unique<ThreadPool>(n_threads);
+        world.pool = pool.get();
+    }
+    spawn_level(world);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < n_ticks; ++tick) {
+        act(world);
+        world.update();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    int n_dudes = world.dudes.size();
+    int n_bullets = world.bullets.size();
+    printf(
+        "ticks: %d, seconds: %.3f, ticks/sec: %.0f\n",
+        n_ticks,
+        seconds,
+        n_ticks / seconds
+    );
+    printf("dudes alive: %d, bullets alive: %d\n", n_dudes, n_bullets);
+}
@@ -1,39 +1,96 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <stdexcept>
 
-template <typename T, uint32_t capacity> class List {
+// Generational reference to a list slot. The slot generation is bumped on every
+// removal, so a handle to a removed element never resolves to the element which
+// later reuses its slot.
+class Handle {
+  public:
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    Handle() = default;
+    Handle(uint32_t index, uint32_t generation)
+        : index(index)
+        , generation(generation) {}
+
+    bool operator==(const Handle &other) const {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!=(const Handle &other) const {
+        return !(*this == other);
+    }
+};
+
+// Fixed capacity list whose live elements are packed in a dense array, so
+// size() and the iteration cost only the live elements, not the capacity.
+template <typename T, uint32_t capacity> class SparseList {
   private:
     T data[capacity];
-    bool occupied[capacity];
+    // Slot indices of the live elements, packed in [0, n).
+    uint32_t dense[capacity];
+    // Position of the slot in the dense array.
+    uint32_t sparse[capacity];
+    uint32_t free_slots[capacity];
+    uint32_t generations[capacity];
+    uint32_t n_free;
+    uint32_t n;
+
+    bool is_live(uint32_t slot) {
+        return slot < capacity && sparse[slot] < n && dense[sparse[slot]] == slot;
+    }
+
+    uint32_t get_slot(T &element) {
+        // std::less gives a total order even for pointers into other arrays
+        std::less<const T *> less;
+        if (less(&element, data) || !less(&element, data + capacity)) {
+            throw std::runtime_error("ERROR: Object is not in the list");
+        }
+
+        uint32_t slot = &element - data;
+        if (!is_live(slot)) {
+            throw std::runtime_error("ERROR: Object is not in the list");
+        }
+        return slot;
+    }
 
   public:
-    class Iterator : public std::iterator<std::input_iterator_tag, T> {
+    // Walks the dense array from back to front, so the element under the
+    // iterator can be removed without skipping any of the remaining ones.
+    class Iterator {
       private:
-        List<T, capacity> &list;
-        uint32_t index;
+        SparseList<T, capacity> &list;
+        uint32_t pos;
 
       public:
-        Iterator(List<T, capacity> &l, uint32_t i)
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T *;
+        using reference = T &;
+
+        Iterator(SparseList<T, capacity> &l, uint32_t p)
             : list(l)
-            , index(i) {}
+            , pos(p) {}
 
         Iterator &operator++() {
-            do {
-                ++index;
-            } while (index < capacity && !list.occupied[index]);
+            --pos;
             return *this;
         }
 
         T &operator*() {
-            return list.data[index];
+            return list.data[list.dense[pos - 1]];
         }
 
         bool operator==(Iterator &other) {
-            return &list == &other.list && index == other.index;
+            return &list == &other.list && pos == other.pos;
         }
 
         bool operator!=(Iterator &other) {
@@ -42,41 +99,59 @@ template <typename T, uint32_t capacity> class List {
     };
 
     Iterator begin() {
-        uint32_t i = 0;
-        while (i < capacity && !occupied[i]) {
-            ++i;
-        }
-        return Iterator(*this, i);
+        return Iterator(*this, n);
     }
 
     Iterator end() {
-        return Iterator(*this, capacity);
+        return Iterator(*this, 0);
     }
 
-    List() {
+    SparseList() {
         for (uint32_t i = 0; i < capacity; ++i) {
-            occupied[i] = false;
+            free_slots[i] = capacity - 1 - i;
+            sparse[i] = capacity;
+            generations[i] = 1;
+        }
+        n_free = capacity;
+        n = 0;
+    }
+
+    Handle get_handle(T &element) {
+        uint32_t slot = get_slot(element);
+        return Handle(slot, generations[slot]);
+    }
+
+    T *get(Handle handle) {
+        if (!is_live(handle.index) || generations[handle.index] != handle.generation) {
+            return NULL;
         }
+        return &data[handle.index];
+    }
+
+    uint32_t size() {
+        return n;
     }
 
     bool insert(T element) {
-        for (uint32_t i = 0; i < capacity; ++i) {
-            if (!occupied[i]) {
-                data[i] = element;
-                occupied[i] = true;
-                return true;
-            }
+        if (n_free == 0) {
+            return false;
         }
-        return false;
+
+        uint32_t slot = free_slots[--n_free];
+        data[slot] = element;
+        dense[n] = slot;
+        sparse[slot] = n;
+        ++n;
+        return true;
     }
 
     void remove(T &element) {
-        for (uint32_t i = 0; i < capacity; ++i) {
-            if (occupied[i] && &data[i] == &element) {
-                occupied[i] = false;
-                return;
-            }
-        }
-        throw std::runtime_error("ERROR: Can't remove, object is not in the list");
+        uint32_t slot = get_slot(element);
+        uint32_t pos = sparse[slot];
+        uint32_t last = dense[--n];
+        dense[pos] = last;
+        sparse[last] = pos;
+        free_slots[n_free++] = slot;
+        ++generations[slot];
     }
 };
@@ -0,0 +1,344 @@
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "replay.hpp"
+
+#define REPLAY_END_TAG 0xff
+// A run of ticks with no changed action: the low bits are the number of ticks.
+// Flags bytes never have this bit, and the longest run stays below the end tag.
+#define REPLAY_RUN_TAG 0x80
+#define REPLAY_MAX_RUN_LENGTH 0x7e
+
+// Flags of a recorded action: which fields follow, and the shooting bit itself
+#define ACTION_MOVE_DIR 1
+#define ACTION_ORIENTATION 2
+#define ACTION_IS_SHOOTING 4
+
+template <typename T> static void write(std::vector<uint8_t> &data, T value) {
+    const uint8_t *bytes = (const uint8_t *)&value;
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T> static T read(const std::vector<uint8_t> &data, size_t *offset) {
+    if (*offset + sizeof(T) > data.size()) {
+        throw std::runtime_error("ERROR: Replay is truncated");
+    }
+
+    T value;
+    std::memcpy(&value, data.data() + *offset, sizeof(T));
+    *offset += sizeof(T);
+    return value;
+}
+
+uint64_t get_world_hash(World &world) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hash = hash_bytes(hash, &world.time, sizeof(world.time));
+    for (Dude &dude : world.dudes) {
+        hash = hash_bytes(hash, &dude.position, sizeof(dude.position));
+        hash = hash_bytes(hash, &dude.orientation, sizeof(dude.orientation));
+        hash = hash_bytes(hash, &dude.health, sizeof(dude.health));
+    }
+    for (Bullet &bullet : world.bullets) {
+        hash = hash_bytes(hash, &bullet.curr_position, sizeof(bullet.curr_position));
+        hash = hash_bytes(hash, &bullet.velocity, sizeof(bullet.velocity));
+    }
+    return hash;
+}
+
+void Replay::save(const char *file_path) {
+    FILE *file = fopen(file_path, "wb");
+    if (!file) {
+        throw std::runtime_error("ERROR: Can't open the replay file for writing");
+    }
+
+    size_t n_written = fwrite(this->data.data(), 1, this->data.size(), file);
+    fclose(file);
+    if (n_written != this->data.size()) {
+        throw std::runtime_error("ERROR: Can't write the replay file");
+    }
+}
+
+void Replay::load(const char *file_path) {
+    FILE *file = fopen(file_path, "rb");
+    if (!file) {
+        throw std::runtime_error("ERROR: Can't open the replay file for reading");
+    }
+
+    this->data.clear();
+    uint8_t buffer[4096];
+    size_t n_read;
+    while ((n_read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        this->data.insert(this->data.end(), buffer, buffer + n_read);
+    }
+    fclose(file);
+}
+
+// Only the fields a dude is spawned with. The per tick and per world ones
+// (the action, the body index and the tree proxy) are rebuilt by the world.
+static void write_dude(std::vector<uint8_t> &data, Dude &dude) {
+    write<uint8_t>(data, (uint8_t)dude.ai_type);
+    write(data, dude.body_radius);
+    write(data, dude.max_health);
+    write(data, dude.move_speed);
+    write(data, dude.fire_rate);
+    write(data, dude.view_distance);
+    write(data, dude.view_angle);
+    write<int32_t>(data, dude.n_view_rays);
+    write(data, dude.position);
+    write(data, dude.orientation);
+    write(data, dude.health);
+    write(data, dude.last_shot_time);
+}
+
+static Dude read_dude(const std::vector<uint8_t> &data, size_t *offset) {
+    Dude dude;
+    dude.ai_type = (AIType)read<uint8_t>(data, offset);
+    dude.body_radius = read<float>(data, offset);
+    dude.max_health = read<float>(data, offset);
+    dude.move_speed = read<float>(data, offset);
+    dude.fire_rate = read<float>(data, offset);
+    dude.view_distance = read<float>(data, offset);
+    dude.view_angle = read<float>(data, offset);
+    dude.n_view_rays = read<int32_t>(data, offset);
+    dude.position = read<Vector2>(data, offset);
+    dude.orientation = read<float>(data, offset);
+    dude.health = read<float>(data, offset);
+    dude.last_shot_time = read<float>(data, offset);
+    return dude;
+}
+
+// -----------------------------------------------------------------------
+// recorder
+void ReplayRecorder::begin(World &world) {
+    if (world.time != 0.0 || !world.bullets.empty()) {
+        throw std::runtime_error("ERROR: Replay must start from a not updated world");
+    }
+
+    std::vector<uint8_t> &data = this->replay.data;
+    data.clear();
+    this->n_ticks = 0;
+    this->n_same_ticks = 0;
+    for (DudeAction &action : this->prev_actions) action = DudeAction();
+
+    write<uint32_t>(data, REPLAY_MAGIC);
+    write<uint32_t>(data, REPLAY_VERSION);
+
+    write(data, world.timestep);
+    write(data, world.bullet_ttl);
+    write(data, world.sensing_backend);
+    write(data, world.collision_backend);
+    write(data, world.dudes_broadphase);
+
+    // The player respawns the dudes and obstacles in the order of the original
+    // spawns, so they get the same slots. The lists iterate from the last
+    // spawned element, so they're written backwards.
+    std::vector<Dude *> dudes;
+    for (Dude &dude : world.dudes) {
+        dudes.push_back(&dude);
+    }
+    write<uint8_t>(data, dudes.size());
+    for (auto dude = dudes.rbegin(); dude != dudes.rend(); ++dude) {
+        write_dude(data, **dude);
+    }
+
+    std::vector<Obstacle *> obstacles;
+    for (Obstacle &obstacle : world.obstacles) {
+        obstacles.push_back(&obstacle);
+    }
+    write<uint16_t>(data, obstacles.size());
+    for (auto it = obstacles.rbegin(); it != obstacles.rend(); ++it) {
+        Obstacle &obstacle = **it;
+        write<uint8_t>(data, obstacle.is_rect);
+        if (obstacle.is_rect) {
+            write(data, obstacle.rect);
+            continue;
+        }
+
+        // the baked shape is stored as is, so it doesn't depend on rebaking
+        ConvexShape &shape = obstacle.shape;
+        write<uint8_t>(data, shape.n);
+        for (int i = 0; i < shape.n; ++i) {
+            write(data, shape.vertices[i]);
+            write(data, shape.normals[i]);
+            write(data, shape.bounds[i]);
+        }
+        write(data, shape.aabb);
+    }
+}
+
+void ReplayRecorder::flush_same_ticks() {
+    if (this->n_same_ticks == 0) return;
+
+    write<uint8_t>(this->replay.data, REPLAY_RUN_TAG | this->n_same_ticks);
+    this->n_same_ticks = 0;
+}
+
+void ReplayRecorder::record(World &world) {
+    std::vector<uint8_t> &data = this->replay.data;
+
+    bool is_any_changed = false;
+    for (Dude &dude : world.dudes) {
+        if (dude.ai_type != AIType::MANUAL) continue;
+
+        DudeAction &prev = this->prev_actions[world.dudes.get_handle(dude).index];
+        DudeAction &action = dude.action;
+        is_any_changed |= action.move_dir.x != prev.move_dir.x
+                          || action.move_dir.y != prev.move_dir.y
+                          || action.orientation != prev.orientation
+                          || action.is_shooting != prev.is_shooting;
+    }
+
+    if (!is_any_changed) {
+        if (++this->n_same_ticks == REPLAY_MAX_RUN_LENGTH) this->flush_same_ticks();
+    } else {
+        this->flush_same_ticks();
+        for (Dude &dude : world.dudes) {
+            if (dude.ai_type != AIType::MANUAL) continue;
+
+            DudeAction &prev = this->prev_actions[world.dudes.get_handle(dude).index];
+            DudeAction action = dude.action;
+            bool is_move_dir_changed = action.move_dir.x != prev.move_dir.x
+                                       || action.move_dir.y != prev.move_dir.y;
+            bool is_orientation_changed = action.orientation != prev.orientation;
+
+            uint8_t flags = 0;
+            if (is_move_dir_changed) flags |= ACTION_MOVE_DIR;
+            if (is_orientation_changed) flags |= ACTION_ORIENTATION;
+            if (action.is_shooting) flags |= ACTION_IS_SHOOTING;
+            write(data, flags);
+            if (is_move_dir_changed) write(data, action.move_dir);
+            if (is_orientation_changed) write(data, action.orientation);
+
+            prev = action;
+        }
+    }
+
+    // the hash follows the tick it's taken at, so the pending run is written
+    if (this->n_ticks++ % REPLAY_HASH_INTERVAL == 0) {
+        this->flush_same_ticks();
+        write(data, get_world_hash(world));
+    }
+}
+
+void ReplayRecorder::end(World &world) {
+    this->flush_same_ticks();
+    write<uint8_t>(this->replay.data, REPLAY_END_TAG);
+    write(this->replay.data, get_world_hash(world));
+}
+
+// -----------------------------------------------------------------------
+// player
+ReplayPlayer::ReplayPlayer(const Replay &replay)
+    : replay(replay) {}
+
+void ReplayPlayer::begin(World &world) {
+    const std::vector<uint8_t> &data = this->replay.data;
+    this->offset = 0;
+    this->n_ticks = 0;
+    this->n_same_ticks = 0;
+    for (DudeAction &action : this->prev_actions) action = DudeAction();
+
+    bool is_header_valid = read<uint32_t>(data, &this->offset) == REPLAY_MAGIC
+                           && read<uint32_t>(data, &this->offset) == REPLAY_VERSION;
+    if (!is_header_valid) {
+        throw std::runtime_error("ERROR: Replay is not compatible with this build");
+    }
+    if (world.time != 0.0 || world.dudes.size() || world.obstacles.size()) {
+        throw std::runtime_error("ERROR: Replay must be played into an empty world");
+    }
+
+    world.timestep = read<float>(data, &this->offset);
+    world.bullet_ttl = read<float>(data, &this->offset);
+    world.sensing_backend = read<SensingBackend>(data, &this->offset);
+    world.collision_backend = read<CollisionBackend>(data, &this->offset);
+    world.dudes_broadphase = read<DudesBroadphase>(data, &this->offset);
+
+    int n_dudes = read<uint8_t>(data, &this->offset);
+    for (int i = 0; i < n_dudes; ++i) {
+        world.spawn_dude(read_dude(data, &this->offset));
+    }
+
+    int n_obstacles = read<uint16_t>(data, &this->offset);
+    for (int i = 0; i < n_obstacles; ++i) {
+        Obstacle obstacle;
+        obstacle.is_rect = read<uint8_t>(data, &this->offset);
+        if (obstacle.is_rect) {
+            obstacle.rect = read<Rectangle>(data, &this->offset);
+            world.spawn_obstacle(obstacle);
+            continue;
+        }
+
+        ConvexShape &shape = obstacle.shape;
+        shape.n = read<uint8_t>(data, &this->offset);
+        if (shape.n > MAX_N_CONVEX_SHAPE_VERTICES) {
+            throw std::runtime_error("ERROR: Replay obstacle has too many vertices");
+        }
+        for (int j = 0; j < shape.n; ++j) {
+            shape.vertices[j] = read<Vector2>(data, &this->offset);
+            shape.normals[j] = read<Vector2>(data, &this->offset);
+            shape.bounds[j] = read<Vector2>(data, &this->offset);
+        }
+        shape.aabb = read<Rectangle>(data, &this->offset);
+        obstacle.rect = shape.aabb;
+        world.spawn_obstacle(obstacle);
+    }
+    world.finish_level();
+}
+
+bool ReplayPlayer::step(World &world) {
+    const std::vector<uint8_t> &data = this->replay.data;
+
+    bool is_same_tick = this->n_same_ticks > 0;
+    if (!is_same_tick) {
+        uint8_t tag = read<uint8_t>(data, &this->offset);
+        if (tag == REPLAY_END_TAG) {
+            if (read<uint64_t>(data, &this->offset) != get_world_hash(world)) {
+                throw std::runtime_error("ERROR: Replay has diverged at its end");
+            }
+            return false;
+        }
+
+        if (tag & REPLAY_RUN_TAG) {
+            this->n_same_ticks = tag & ~REPLAY_RUN_TAG;
+            is_same_tick = true;
+        } else {
+            // not a tag, but the flags of the first action
+            --this->offset;
+        }
+    }
+    if (is_same_tick) --this->n_same_ticks;
+
+    int n_actions = 0;
+    for (Dude &dude : world.dudes) {
+        if (dude.ai_type != AIType::MANUAL) continue;
+
+        DudeAction &prev = this->prev_actions[world.dudes.get_handle(dude).index];
+        if (!is_same_tick) {
+            uint8_t flags = read<uint8_t>(data, &this->offset);
+            if (flags & ACTION_MOVE_DIR) {
+                prev.move_dir = read<Vector2>(data, &this->offset);
+            }
+            if (flags & ACTION_ORIENTATION) {
+                prev.orientation = read<float>(data, &this->offset);
+            }
+            prev.is_shooting = flags & ACTION_IS_SHOOTING;
+        }
+        dude.action = prev;
+        ++n_actions;
+    }
+    if (!is_same_tick && n_actions == 0) {
+        throw std::runtime_error("ERROR: Replay has diverged, no dude for the actions");
+    }
+
+    if (this->n_ticks++ % REPLAY_HASH_INTERVAL == 0) {
+        if (read<uint64_t>(data, &this->offset) != get_world_hash(world)) {
+            throw std::runtime_error(
+                "ERROR: Replay has diverged from the recorded hash"
+            );
+        }
+    }
+
+    world.update();
+    return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "world.hpp"
+
+#define REPLAY_MAGIC 0x32525843  // "CXR2"
+#define REPLAY_VERSION 2
+#define REPLAY_HASH_INTERVAL 60
+
+// Hash of the world state which a replay must reproduce exactly: the time,
+// the dudes and the bullets
+uint64_t get_world_hash(World &world);
+
+// A match recorded as its initial setup plus the actions of the manual dudes,
+// every other dude acts on its own and the simulation is deterministic. The
+// data is one flat byte stream:
+//   header, world settings, dudes (their spawn fields), obstacles
+//   per tick: either the actions of the manual dudes, each stored as a flags
+//   byte followed by the fields which changed since the previous tick, or a
+//   run byte which covers up to 126 ticks in which no action has changed;
+//   the world hash after every REPLAY_HASH_INTERVAL-th tick
+//   end tag and the final world hash
+// The manual dudes are the ones spawned with the level, so their number is
+// not stored per tick.
+class Replay {
+  public:
+    std::vector<uint8_t> data;
+
+    void save(const char *file_path);
+    void load(const char *file_path);
+};
+
+// Records a world from its first tick: begin() right after the level is
+// spawned, record() before every world update and end() after the last one.
+class ReplayRecorder {
+  private:
+    DudeAction prev_actions[MAX_N_DUDES];
+    uint32_t n_ticks = 0;
+    // Ticks with no changed action which are not written yet
+    uint8_t n_same_ticks = 0;
+
+    void flush_same_ticks();
+
+  public:
+    Replay replay;
+
+    void begin(World &world);
+    void record(World &world);
+    void end(World &world);
+};
+
+// Resimulates a replay into a fresh world: begin() spawns the recorded level,
+// then every step() updates the world by one tick with the recorded actions.
+// Throws as soon as the world hash differs from the recorded one.
+class ReplayPlayer {
+  private:
+    const Replay &replay;
+    size_t offset = 0;
+    DudeAction prev_actions[MAX_N_DUDES];
+    // Ticks left in the current run with no changed action
+    uint8_t n_same_ticks = 0;
+
+  public:
+    uint32_t n_ticks = 0;
+
+    ReplayPlayer(const Replay &replay);
+
+    void begin(World &world);
+    // Returns false once the replay is over and its final hash is verified
+    bool step(World &world);
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// FIFO of elements which are removed mostly in insertion order. Popping the
+// front is a single head advance. Elements removed out of order are only
+// marked dead and get reclaimed once the head passes them. The elements live
+// in fixed-size chunks which are allocated on demand and never moved, so
+// pointers to them stay valid while they're alive. A chunk passed by the head
+// is reused by the tail, so steady-state pushing doesn't allocate.
+template <typename T, uint32_t chunk_size = 64> class RingBuffer {
+  private:
+    class Chunk {
+      public:
+        T data[chunk_size];
+        bool alive[chunk_size];
+    };
+
+    // Owns every chunk ever allocated, each one is either used or free
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    // Chunks covering [head, tail) in order, used[0] is the chunk first_chunk
+    std::vector<Chunk *> used;
+    std::vector<Chunk *> free_chunks;
+    // Absolute positions, the chunk of a position is `pos / chunk_size`
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    uint64_t first_chunk = 0;
+    uint32_t n = 0;
+
+    Chunk *get_chunk(uint64_t pos) {
+        return used[pos / chunk_size - first_chunk];
+    }
+
+    bool is_alive(uint64_t pos) {
+        return get_chunk(pos)->alive[pos % chunk_size];
+    }
+
+    Chunk *take_free_chunk() {
+        if (free_chunks.empty()) {
+            chunks.push_back(std::make_unique<Chunk>());
+            return chunks.back().get();
+        }
+
+        Chunk *chunk = free_chunks.back();
+        free_chunks.pop_back();
+        return chunk;
+    }
+
+    // The chunk left behind by the head goes back to the free ones
+    void advance_head() {
+        ++head;
+        if (head % chunk_size == 0) {
+            free_chunks.push_back(used.front());
+            used.erase(used.begin());
+            ++first_chunk;
+        }
+    }
+
+    // Moves the head past the dead elements, so the front is always alive.
+    void skip_dead() {
+        while (head != tail && !is_alive(head)) {
+            advance_head();
+        }
+    }
+
+  public:
+    class Iterator {
+      private:
+        RingBuffer<T, chunk_size> &ring;
+        uint64_t pos;
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T *;
+        using reference = T &;
+
+        Iterator(RingBuffer<T, chunk_size> &r, uint64_t p)
+            : ring(r)
+            , pos(p) {}
+
+        // If the element under the iterator was removed, the head may have
+        // moved past it, but only over dead elements
+        Iterator &operator++() {
+            pos = std::max(pos + 1, ring.head);
+            while (pos != ring.tail && !ring.is_alive(pos)) {
+                ++pos;
+            }
+            return *this;
+        }
+
+        T &operator*() {
+            return ring.get_chunk(pos)->data[pos % chunk_size];
+        }
+
+        bool operator==(Iterator &other) {
+            return &ring == &other.ring && pos == other.pos;
+        }
+
+        bool operator!=(Iterator &other) {
+            return !(*this == other);
+        }
+    };
+
+    Iterator begin() {
+        return Iterator(*this, head);
+    }
+
+    Iterator end() {
+        return Iterator(*this, tail);
+    }
+
+    RingBuffer() = default;
+
+    RingBuffer(const RingBuffer &other) {
+        *this = other;
+    }
+
+    // The chunks of this ring are reused, so copying into the same ring again
+    // doesn't allocate
+    RingBuffer &operator=(const RingBuffer &other) {
+        if (this == &other) return *this;
+
+        free_chunks.insert(free_chunks.end(), used.begin(), used.end());
+        used.clear();
+        for (Chunk *other_chunk : other.used) {
+            Chunk *chunk = take_free_chunk();
+            *chunk = *other_chunk;
+            used.push_back(chunk);
+        }
+
+        head = other.head;
+        tail = other.tail;
+        first_chunk = other.first_chunk;
+        n = other.n;
+        return *this;
+    }
+
+    uint32_t size() {
+        return n;
+    }
+
+    bool empty() {
+        return n == 0;
+    }
+
+    T &front() {
+        return get_chunk(head)->data[head % chunk_size];
+    }
+
+    void push_back(T element) {
+        if (tail % chunk_size == 0) {
+            used.push_back(take_free_chunk());
+        }
+
+        Chunk *chunk = get_chunk(tail);
+        chunk->data[tail % chunk_size] = element;
+        chunk->alive[tail % chunk_size] = true;
+        ++tail;
+        ++n;
+    }
+
+    void pop_front() {
+        get_chunk(head)->alive[head % chunk_size] = false;
+        --n;
+        advance_head();
+        skip_dead();
+    }
+
+    void remove(T &element) {
+        std::less<const T *> less;
+        for (uint32_t i = 0; i < used.size(); ++i) {
+            T *data = used[i]->data;
+            if (less(&element, data) || !less(&element, data + chunk_size)) continue;
+
+            uint64_t pos = (first_chunk + i) * chunk_size + (&element - data);
+            if (pos < head || pos >= tail || !used[i]->alive[pos % chunk_size]) break;
+
+            used[i]->alive[pos % chunk_size] = false;
+            --n;
+            skip_dead();
+            return;
+        }
+        throw std::runtime_error("ERROR: Can't remove, object is not in the ring");
+    }
+};
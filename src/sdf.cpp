@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cfloat>
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "sdf.hpp"
+
+#define SDF_N_PUSH_OUT_STEPS 2
+#define SDF_MAX_N_TRACE_STEPS 64
+#define SDF_TRACE_HIT_DIST 1e-2
+
+Vector2 SDF::clamp_to_bounds(Vector2 point) {
+    float size_x = (this->n_cols - 1) * this->cell_size;
+    float size_y = (this->n_rows - 1) * this->cell_size;
+    return {
+        std::clamp(point.x, this->origin.x, this->origin.x + size_x),
+        std::clamp(point.y, this->origin.y, this->origin.y + size_y)};
+}
+
+float SDF::get_dist(Vector2 point) {
+    Vector2 clamped = this->clamp_to_bounds(point);
+    if (clamped.x != point.x || clamped.y != point.y) {
+        return Vector2Distance(point, clamped) + this->padding;
+    }
+
+    float fx = (point.x - this->origin.x) / this->cell_size;
+    float fy = (point.y - this->origin.y) / this->cell_size;
+    int x = std::min((int)fx, this->n_cols - 2);
+    int y = std::min((int)fy, this->n_rows - 2);
+    float tx = fx - x;
+    float ty = fy - y;
+
+    float d00 = this->get_node_dist(x, y);
+    float d10 = this->get_node_dist(x + 1, y);
+    float d01 = this->get_node_dist(x, y + 1);
+    float d11 = this->get_node_dist(x + 1, y + 1);
+    float d0 = d00 + (d10 - d00) * tx;
+    float d1 = d01 + (d11 - d01) * tx;
+    return d0 + (d1 - d0) * ty;
+}
+
+// Gradient of the bilinear interpolation, points away from the obstacles
+Vector2 SDF::get_gradient(Vector2 point) {
+    Vector2 clamped = this->clamp_to_bounds(point);
+    if (clamped.x != point.x || clamped.y != point.y) {
+        return Vector2Normalize(Vector2Subtract(point, clamped));
+    }
+
+    float fx = (point.x - this->origin.x) / this->cell_size;
+    float fy = (point.y - this->origin.y) / this->cell_size;
+    int x = std::min((int)fx, this->n_cols - 2);
+    int y = std::min((int)fy, this->n_rows - 2);
+    float tx = fx - x;
+    float ty = fy - y;
+
+    float d00 = this->get_node_dist(x, y);
+    float d10 = this->get_node_dist(x + 1, y);
+    float d01 = this->get_node_dist(x, y + 1);
+    float d11 = this->get_node_dist(x + 1, y + 1);
+    float dx = (d10 - d00) * (1.0 - ty) + (d11 - d01) * ty;
+    float dy = (d01 - d00) * (1.0 - tx) + (d11 - d10) * tx;
+    return Vector2Scale({dx, dy}, 1.0 / this->cell_size);
+}
+
+Vector2 SDF::get_circle_mtv(Vector2 position, float radius) {
+    // a single step along the gradient undershoots near the corners, where
+    // the interpolated field is not exact, a second one fixes most of it
+    Vector2 mtv = Vector2Zero();
+    for (int i = 0; i < SDF_N_PUSH_OUT_STEPS; ++i) {
+        Vector2 curr_position = Vector2Add(position, mtv);
+        float dist = this->get_dist(curr_position);
+        if (dist >= radius) break;
+
+        Vector2 dir = Vector2Normalize(this->get_gradient(curr_position));
+        mtv = Vector2Add(mtv, Vector2Scale(dir, radius - dist));
+    }
+
+    return mtv;
+}
+
+float SDF::get_line_intersection_t(Vector2 start, Vector2 end) {
+    float length = Vector2Distance(start, end);
+    if (length < EPSILON) return FLT_MAX;
+
+    // clip the line to the grid (slab method), there is nothing to hit outside
+    float t_enter = 0.0;
+    float t_exit = 1.0;
+    float starts[2] = {start.x - this->origin.x, start.y - this->origin.y};
+    float deltas[2] = {end.x - start.x, end.y - start.y};
+    float sizes[2] = {
+        (this->n_cols - 1) * this->cell_size, (this->n_rows - 1) * this->cell_size};
+    for (int axis = 0; axis < 2; ++axis) {
+        if (deltas[axis] == 0.0) {
+            if (starts[axis] < 0.0 || starts[axis] > sizes[axis]) return FLT_MAX;
+            continue;
+        }
+
+        float t0 = -starts[axis] / deltas[axis];
+        float t1 = (sizes[axis] - starts[axis]) / deltas[axis];
+        t_enter = std::max(t_enter, std::min(t0, t1));
+        t_exit = std::min(t_exit, std::max(t0, t1));
+    }
+    if (t_enter > t_exit) return FLT_MAX;
+
+    Vector2 dir = Vector2Scale(Vector2Subtract(end, start), 1.0 / length);
+    float dist = t_enter * length;
+    float max_dist = t_exit * length;
+    for (int i = 0; i < SDF_MAX_N_TRACE_STEPS; ++i) {
+        float step = this->get_dist(Vector2Add(start, Vector2Scale(dir, dist)));
+        if (step < SDF_TRACE_HIT_DIST) return dist / length;
+
+        dist += step;
+        if (dist > max_dist) break;
+    }
+
+    return FLT_MAX;
+}
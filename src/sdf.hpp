@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+
+#include "raylib.h"
+
+// Signed distance field of static obstacles, baked into a grid of nodes and
+// sampled with bilinear interpolation. The grid bounds keep at least the
+// padding from every obstacle, so outside the grid the distance to the bounds
+// plus the padding is a lower bound of the distance to the obstacles: the
+// plane outside is free, and sphere tracing never steps over an obstacle.
+class SDF {
+  private:
+    Vector2 origin;
+    float cell_size = 0.0;
+    float padding = 0.0;
+    int n_cols = 0;
+    int n_rows = 0;
+    std::vector<float> dists;
+
+    float get_node_dist(int x, int y) {
+        return this->dists[y * this->n_cols + x];
+    }
+
+    Vector2 clamp_to_bounds(Vector2 point);
+
+  public:
+    // get_dist(point) returns the exact signed distance at the point. Every
+    // obstacle must be at least the padding away from the bounds. The cell
+    // size is doubled until the grid has at most max_n_nodes nodes.
+    template <typename GetDist>
+    void bake(
+        Rectangle bounds,
+        float padding,
+        float cell_size,
+        int max_n_nodes,
+        GetDist get_dist
+    ) {
+        this->origin = {bounds.x, bounds.y};
+        this->padding = padding;
+        this->cell_size = cell_size;
+        while (true) {
+            this->n_cols = (int)(bounds.width / this->cell_size) + 2;
+            this->n_rows = (int)(bounds.height / this->cell_size) + 2;
+            if ((long long)this->n_cols * this->n_rows <= max_n_nodes) break;
+            this->cell_size *= 2.0;
+        }
+
+        this->dists.resize(this->n_cols * this->n_rows);
+        for (int y = 0; y < this->n_rows; ++y) {
+            for (int x = 0; x < this->n_cols; ++x) {
+                Vector2 point = {
+                    this->origin.x + x * this->cell_size,
+                    this->origin.y + y * this->cell_size};
+                this->dists[y * this->n_cols + x] = get_dist(point);
+            }
+        }
+    }
+
+    bool is_baked() {
+        return !this->dists.empty();
+    }
+
+    float get_dist(Vector2 point);
+    Vector2 get_gradient(Vector2 point);
+
+    // Vector which pushes the circle out of the obstacles, zero for a circle
+    // outside the grid which isn't larger than the padding
+    Vector2 get_circle_mtv(Vector2 position, float radius);
+
+    // Sphere traced hit t in [0, 1] of the line, FLT_MAX if nothing is hit.
+    // Only the part of the line inside the grid is traced.
+    float get_line_intersection_t(Vector2 start, Vector2 end);
+};
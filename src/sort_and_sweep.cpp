@@ -0,0 +1,67 @@
+#include "sort_and_sweep.hpp"
+
+void SortAndSweep::set(int key, int id, Rectangle aabb) {
+    if (key >= (int)this->item_by_key.size()) {
+        this->item_by_key.resize(key + 1, -1);
+    }
+
+    // new items are appended, sort() moves them into place
+    int i = this->item_by_key[key];
+    if (i == -1) {
+        i = this->items.size();
+        this->items.emplace_back();
+        this->item_by_key[key] = i;
+    }
+
+    Item &item = this->items[i];
+    item.key = key;
+    item.id = id;
+    item.min_x = aabb.x;
+    item.max_x = aabb.x + aabb.width;
+    item.min_y = aabb.y;
+    item.max_y = aabb.y + aabb.height;
+    item.is_set = true;
+}
+
+void SortAndSweep::sort() {
+    // drop the items which were not set, keeping the order of the rest
+    int n_items = 0;
+    for (Item &item : this->items) {
+        if (item.is_set) {
+            this->items[n_items++] = item;
+        } else {
+            this->item_by_key[item.key] = -1;
+        }
+    }
+    this->items.resize(n_items);
+
+    for (int i = 1; i < n_items; ++i) {
+        Item item = this->items[i];
+        int j = i;
+        while (j > 0 && this->items[j - 1].min_x > item.min_x) {
+            this->items[j] = this->items[j - 1];
+            --j;
+        }
+        this->items[j] = item;
+    }
+
+    for (int i = 0; i < n_items; ++i) {
+        this->item_by_key[this->items[i].key] = i;
+        this->items[i].is_set = false;
+    }
+}
+
+int SortAndSweep::query(Rectangle aabb, int out_ids[], int max_n_ids) {
+    int n = 0;
+    for (Item &item : this->items) {
+        if (item.min_x > aabb.x + aabb.width) break;
+        if (item.max_x < aabb.x || item.min_y > aabb.y + aabb.height
+            || item.max_y < aabb.y) {
+            continue;
+        }
+        if (n == max_n_ids) return n;
+        out_ids[n++] = item.id;
+    }
+
+    return n;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include "raylib.h"
+
+// Boxes kept sorted by their left x between ticks. Items move a little per
+// tick, so the insertion sort which restores the order is close to linear.
+// Every item is identified by a persistent key (e.g. a list slot) and carries
+// an id reported by the queries, which may change from tick to tick.
+class SortAndSweep {
+  private:
+    class Item {
+      public:
+        int key;
+        int id;
+        float min_x;
+        float max_x;
+        float min_y;
+        float max_y;
+        bool is_set;
+    };
+
+    std::vector<Item> items;
+    std::vector<int> item_by_key;
+
+  public:
+    // Sets the box of the item for the current tick. Items which are not set
+    // before the next sort() are removed.
+    void set(int key, int id, Rectangle aabb);
+    void sort();
+
+    // Writes ids of the items overlapping the aabb, returns their count
+    int query(Rectangle aabb, int out_ids[], int max_n_ids);
+
+    // Calls on_pair(id_a, id_b) once for every pair of overlapping items
+    template <typename OnPair> void query_pairs(OnPair on_pair) {
+        int n_items = this->items.size();
+        for (int i = 0; i < n_items; ++i) {
+            Item &a = this->items[i];
+            for (int j = i + 1; j < n_items; ++j) {
+                Item &b = this->items[j];
+                if (b.min_x > a.max_x) break;
+                if (b.min_y <= a.max_y && a.min_y <= b.max_y) on_pair(a.id, b.id);
+            }
+        }
+    }
+};
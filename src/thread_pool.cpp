@@ -0,0 +1,65 @@
+#include <algorithm>
+
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(int n_threads) {
+    if (n_threads <= 0) {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (int i = 1; i < n_threads; ++i) {
+        this->workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->is_stopping = true;
+    }
+    this->job_cv.notify_all();
+    for (std::thread &worker : this->workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::get_n_threads() {
+    return this->workers.size() + 1;
+}
+
+void ThreadPool::work(int thread_idx) {
+    uint64_t last_generation = 0;
+    while (true) {
+        std::function<void(int)> job;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->job_cv.wait(lock, [&] {
+                return this->is_stopping || this->job_generation != last_generation;
+            });
+            if (this->is_stopping) return;
+
+            last_generation = this->job_generation;
+            job = this->job;
+        }
+
+        job(thread_idx);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (--this->n_busy_workers == 0) this->done_cv.notify_one();
+    }
+}
+
+void ThreadPool::run(std::function<void(int thread_idx)> job) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->job = job;
+        this->n_busy_workers = this->workers.size();
+        ++this->job_generation;
+    }
+    this->job_cv.notify_all();
+
+    job(0);
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->done_cv.wait(lock, [&] { return this->n_busy_workers == 0; });
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads which all run the same job. The calling thread
+// takes part as the thread 0, so a pool of 1 thread has no workers at all.
+class ThreadPool {
+  private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable job_cv;
+    std::condition_variable done_cv;
+    std::function<void(int)> job;
+    uint64_t job_generation = 0;
+    int n_busy_workers = 0;
+    bool is_stopping = false;
+
+    void work(int thread_idx);
+
+  public:
+    // 0 threads means one per hardware thread
+    ThreadPool(int n_threads);
+    ~ThreadPool();
+
+    int get_n_threads();
+
+    // Calls job(thread_idx) on every thread and waits for all of them
+    void run(std::function<void(int thread_idx)> job);
+};
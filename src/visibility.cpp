@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "visibility.hpp"
+
+static float cross(Vector2 a, Vector2 b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+// Hit t of the ray from the origin along the dir with the segment, FLT_MAX if
+// there is no hit. The ray is not limited in length.
+static float get_ray_segment_intersection_t(
+    Vector2 origin, Vector2 dir, Vector2 start, Vector2 end
+) {
+    Vector2 edge = Vector2Subtract(end, start);
+    float denom = cross(dir, edge);
+    if (fabs(denom) < EPSILON) return FLT_MAX;
+
+    Vector2 to_start = Vector2Subtract(start, origin);
+    float t = cross(to_start, edge) / denom;
+    float u = cross(to_start, dir) / denom;
+    if (t < 0.0 || u < 0.0 || u > 1.0) return FLT_MAX;
+    return t;
+}
+
+void VisibilityPolygon::reset(
+    Vector2 origin, float radius, float orientation, float span_angle
+) {
+    this->origin = origin;
+    this->radius = radius;
+    this->orientation = orientation;
+    this->forward = {cosf(orientation), sinf(orientation)};
+    this->half_span = 0.5 * std::min(span_angle, 2.0f * PI);
+    this->edges.clear();
+    this->angles.clear();
+    this->edge_ids.clear();
+}
+
+void VisibilityPolygon::add_edge(Vector2 start, Vector2 end, Vector2 outward_normal) {
+    Vector2 to_origin = Vector2Subtract(this->origin, start);
+    if (Vector2DotProduct(outward_normal, to_origin) > 0.0) {
+        this->edges.push_back({start, end});
+    }
+}
+
+float VisibilityPolygon::get_relative_angle(Vector2 point) {
+    Vector2 dir = Vector2Subtract(point, this->origin);
+    return atan2f(cross(this->forward, dir), Vector2DotProduct(this->forward, dir));
+}
+
+void VisibilityPolygon::add_critical_angle(Vector2 point) {
+    if (Vector2Distance(point, this->origin) > this->radius) return;
+
+    float angle = this->get_relative_angle(point);
+    if (fabs(angle) < this->half_span) this->angles.push_back(angle);
+}
+
+void VisibilityPolygon::build() {
+    this->angles.push_back(-this->half_span);
+    this->angles.push_back(this->half_span);
+
+    int n_edges = this->edges.size();
+    for (int i = 0; i < n_edges; ++i) {
+        Edge &edge = this->edges[i];
+        this->add_critical_angle(edge.start);
+        this->add_critical_angle(edge.end);
+
+        // crossings with the view circle: |start + k * dir - origin| = radius
+        Vector2 dir = Vector2Subtract(edge.end, edge.start);
+        Vector2 to_start = Vector2Subtract(edge.start, this->origin);
+        float a = Vector2DotProduct(dir, dir);
+        float b = 2.0 * Vector2DotProduct(dir, to_start);
+        float c = Vector2DotProduct(to_start, to_start) - this->radius * this->radius;
+        float discr = b * b - 4.0 * a * c;
+        if (a > EPSILON && discr > 0.0) {
+            float sqrt_discr = sqrtf(discr);
+            float ks[2] = {
+                (-b - sqrt_discr) / (2.0f * a), (-b + sqrt_discr) / (2.0f * a)};
+            for (float k : ks) {
+                if (k < 0.0 || k > 1.0) continue;
+                float angle = this->get_relative_angle(
+                    Vector2Add(edge.start, Vector2Scale(dir, k))
+                );
+                if (fabs(angle) < this->half_span) this->angles.push_back(angle);
+            }
+        }
+
+        // crossings with other edges (overlapping obstacles)
+        for (int j = i + 1; j < n_edges; ++j) {
+            Edge &other = this->edges[j];
+            Vector2 other_dir = Vector2Subtract(other.end, other.start);
+            float k = get_ray_segment_intersection_t(
+                edge.start, dir, other.start, other.end
+            );
+            if (k <= 1.0 && fabs(cross(dir, other_dir)) > EPSILON) {
+                this->add_critical_angle(Vector2Add(edge.start, Vector2Scale(dir, k)));
+            }
+        }
+    }
+
+    std::sort(this->angles.begin(), this->angles.end());
+
+    // ---------------------------------------------------------------
+    // the edge visible inside the interval is the one hit in its middle
+    int n_intervals = this->angles.size() - 1;
+    this->edge_ids.resize(n_intervals);
+    for (int i = 0; i < n_intervals; ++i) {
+        float angle = this->orientation
+                      + 0.5 * (this->angles[i] + this->angles[i + 1]);
+        Vector2 dir = {cosf(angle), sinf(angle)};
+
+        int edge_id = -1;
+        float nearest_t = this->radius;
+        for (int j = 0; j < n_edges; ++j) {
+            Edge &edge = this->edges[j];
+            float t = get_ray_segment_intersection_t(
+                this->origin, dir, edge.start, edge.end
+            );
+            if (t < nearest_t) {
+                nearest_t = t;
+                edge_id = j;
+            }
+        }
+        this->edge_ids[i] = edge_id;
+    }
+}
+
+float VisibilityPolygon::get_line_intersection_t(Vector2 end, float relative_angle) {
+    int n_intervals = this->edge_ids.size();
+    int i = std::upper_bound(this->angles.begin(), this->angles.end(), relative_angle)
+            - this->angles.begin() - 1;
+    i = std::clamp(i, 0, n_intervals - 1);
+
+    int edge_id = this->edge_ids[i];
+    if (edge_id == -1) return FLT_MAX;
+
+    // the whole interval sees this edge, so the line is cut by its support line
+    Edge &edge = this->edges[edge_id];
+    Vector2 dir = Vector2Subtract(end, this->origin);
+    Vector2 edge_dir = Vector2Subtract(edge.end, edge.start);
+    float denom = cross(dir, edge_dir);
+    if (fabs(denom) < EPSILON) return FLT_MAX;
+
+    float t = cross(Vector2Subtract(edge.start, this->origin), edge_dir) / denom;
+    if (t < 0.0 || t > 1.0) return FLT_MAX;
+    return t;
+}
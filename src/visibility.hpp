@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include "raylib.h"
+
+// Part of the plane visible from the origin within a view cone and a view
+// distance, built by an angular sweep over the obstacle edges. The cone is
+// split at the critical angles (edge endpoints, edge crossings, and edge
+// crossings with the view circle). Inside each angular interval the same edge
+// (or nothing) is visible, so a ray in any direction is answered exactly by
+// a single line intersection, however many rays are sampled.
+class VisibilityPolygon {
+  private:
+    class Edge {
+      public:
+        Vector2 start;
+        Vector2 end;
+    };
+
+    Vector2 origin;
+    float radius;
+    float orientation;
+    Vector2 forward;
+    float half_span;
+
+    std::vector<Edge> edges;
+    // Interval borders relative to the orientation, sorted
+    std::vector<float> angles;
+    // Edge visible inside the interval, -1 if nothing is visible
+    std::vector<int> edge_ids;
+
+    float get_relative_angle(Vector2 point);
+    void add_critical_angle(Vector2 point);
+
+  public:
+    void reset(Vector2 origin, float radius, float orientation, float span_angle);
+    // Only the edges facing the origin are kept: the first hit of any ray
+    // cast from outside the obstacles is on such an edge
+    void add_edge(Vector2 start, Vector2 end, Vector2 outward_normal);
+    void build();
+
+    // Hit t in [0, 1] of the line from the origin to the end, FLT_MAX if
+    // nothing is visible in this direction. The angle of the line relative to
+    // the orientation is passed by the caller, who usually knows it already
+    // (e.g. from the fan step), which saves an atan2 per line.
+    float get_line_intersection_t(Vector2 end, float relative_angle);
+};
@@ -0,0 +1,229 @@
+#include "world.hpp"
+
+uint64_t hash_bytes(uint64_t hash, const void *bytes, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        hash ^= ((const uint8_t *)bytes)[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+// Runs in the parallel move pass: writes only this dude and its own body slot
+void Dude::update(World &world) {
+    // update controls
+    DudeAction action;
+    switch (this->ai_type) {
+        case AIType::MANUAL: {
+            action = this->action;
+            break;
+        }
+        case AIType::DUMMY: {
+            action.move_dir = {-0.1, 0.0};
+            action.orientation = this->orientation;
+            break;
+        }
+        default: {
+            action.orientation = this->orientation;
+            break;
+        }
+    }
+    this->apply_action(world, action);
+
+    // -------------------------------------------------------------------
+    // update collisions
+    if (world.collision_backend == CollisionBackend::SDF) {
+        Vector2 mtv = world.obstacles_sdf.get_circle_mtv(
+            this->position, this->body_radius
+        );
+        this->position = Vector2Add(this->position, mtv);
+    } else {
+        Rectangle body_area = get_circle_aabb(this->position, this->body_radius);
+        ObstaclesSubset obstacles;
+        world.query_obstacles(body_area, &obstacles);
+        Vector2 mtv = get_circle_rects_mtv(
+            this->position, this->body_radius, obstacles.rects, obstacles.n_rects
+        );
+        this->position = Vector2Add(this->position, mtv);
+        for (int i = 0; i < obstacles.n_shapes; ++i) {
+            mtv = get_circle_convex_shape_mtv(
+                this->position, this->body_radius, obstacles.shapes[i]
+            );
+            this->position = Vector2Add(this->position, mtv);
+        }
+    }
+
+    // collisions with other dudes are resolved by the world, once per pair
+    world.dude_bodies.set_next_position(this->body_idx, this->position);
+}
+
+void Dude::apply_action(World &world, DudeAction action) {
+    float move_length = Vector2Length(action.move_dir);
+    if (move_length > 0.0) {
+        float dist = world.timestep * this->move_speed * std::min(move_length, 1.0f);
+        Vector2 step = Vector2Scale(action.move_dir, dist / move_length);
+        this->position = Vector2Add(this->position, step);
+    }
+
+    this->orientation = action.orientation;
+
+    bool is_shot = action.is_shooting
+                   && (world.time - this->last_shot_time) >= 1.0 / this->fire_rate;
+    if (is_shot) this->last_shot_time = world.time;
+    world.dude_bodies.is_shooting[this->body_idx] = is_shot;
+}
+
+void Dude::update_view(World &world) {
+    if (this->body_idx == -1) return;
+
+    if (this->n_view_rays <= 8) {
+        this->update_view_rays<8>(world);
+    } else if (this->n_view_rays <= 16) {
+        this->update_view_rays<16>(world);
+    } else if (this->n_view_rays <= 32) {
+        this->update_view_rays<32>(world);
+    } else if (this->n_view_rays <= 64) {
+        this->update_view_rays<64>(world);
+    } else if (this->n_view_rays <= 128) {
+        this->update_view_rays<128>(world);
+    } else {
+        this->update_view_rays<256>(world);
+    }
+}
+
+template <int N> void Dude::update_view_rays(World &world) {
+    // the default view angle with exactly N rays takes a precomputed fan
+    static constexpr RaysFanOffsets<N> default_offsets = get_rays_fan_offsets<N>(
+        DEFAULT_DUDE_VIEW_ANGLE
+    );
+
+    RaysFan<N> view_rays_fan;
+    if (this->n_view_rays == N && this->view_angle == (float)DEFAULT_DUDE_VIEW_ANGLE) {
+        view_rays_fan = get_rays_fan(
+            this->position, this->view_distance, this->orientation, default_offsets
+        );
+    } else {
+        view_rays_fan = get_rays_fan<N>(
+            this->position,
+            this->n_view_rays,
+            this->view_distance,
+            this->view_angle,
+            this->orientation
+        );
+    }
+
+    // only the candidates around the fan are tested
+    Rectangle view_area = get_circle_aabb(this->position, this->view_distance);
+
+    float obstacle_t[N];
+    if (world.sensing_backend == SensingBackend::OCCUPANCY_GRID) {
+        OccupancyGrid &grid = world.obstacles_occupancy_grid;
+        for (int i = 0; i < view_rays_fan.n; ++i) {
+            Vector2 start = view_rays_fan.start;
+            Vector2 end = {view_rays_fan.end_x[i], view_rays_fan.end_y[i]};
+            obstacle_t[i] = grid.cast_line(start, end, [&](int id) {
+                return world.get_line_obstacle_intersection_t(id, start, end);
+            });
+        }
+    } else if (world.sensing_backend == SensingBackend::VISIBILITY_POLYGON) {
+        VisibilityPolygon *visibility = world.get_view_visibility(*this);
+        world.get_visibility_polygon(
+            this->position,
+            this->view_distance,
+            this->orientation,
+            this->view_angle,
+            visibility
+        );
+        int n = view_rays_fan.n;
+        float step = n > 1 ? this->view_angle / (n - 1) : 0.0;
+        float angle = n > 1 ? -0.5 * this->view_angle : 0.0;
+        for (int i = 0; i < n; ++i) {
+            obstacle_t[i] = visibility->get_line_intersection_t(
+                {view_rays_fan.end_x[i], view_rays_fan.end_y[i]}, angle + i * step
+            );
+        }
+    } else if (world.sensing_backend == SensingBackend::SDF) {
+        for (int i = 0; i < view_rays_fan.n; ++i) {
+            obstacle_t[i] = world.obstacles_sdf.get_line_intersection_t(
+                view_rays_fan.start, {view_rays_fan.end_x[i], view_rays_fan.end_y[i]}
+            );
+        }
+    } else {
+        ObstaclesSubset obstacles;
+        world.query_obstacles(view_area, &obstacles);
+        get_rays_fan_rects_intersections_nearest(
+            &view_rays_fan, obstacles.rects, obstacles.n_rects, obstacle_t
+        );
+        for (int i = 0; i < view_rays_fan.n; ++i) {
+            for (int j = 0; j < obstacles.n_shapes; ++j) {
+                float t = get_line_convex_shape_intersection_t(
+                    view_rays_fan.start,
+                    {view_rays_fan.end_x[i], view_rays_fan.end_y[i]},
+                    obstacles.shapes[j]
+                );
+                obstacle_t[i] = std::min(obstacle_t[i], t);
+            }
+        }
+    }
+
+    BodiesSubset nearby;
+    world.query_bodies(view_area, this->body_idx, &nearby);
+    float dude_t[N];
+    int dude_ids[N];
+    get_rays_fan_circles_intersections_nearest(
+        &view_rays_fan,
+        nearby.x,
+        nearby.y,
+        nearby.radius,
+        nearby.n,
+        -1,
+        dude_t,
+        dude_ids
+    );
+
+    ViewRayInfo *view_ray_infos = world.get_view_ray_infos(*this);
+    Vector2 hit_position;
+    for (int i = 0; i < view_rays_fan.n; ++i) {
+        Vector2 start = view_rays_fan.start;
+        Vector2 end = {view_rays_fan.end_x[i], view_rays_fan.end_y[i]};
+
+        ViewRayInfo &info = view_ray_infos[i];
+        info.reset(this->position, end);
+
+        if (obstacle_t[i] <= 1.0) {
+            hit_position = Vector2Lerp(start, end, obstacle_t[i]);
+            info.hit(hit_position, ViewRayTarget::OBSTACLE);
+        }
+
+        if (dude_ids[i] != -1) {
+            hit_position = Vector2Lerp(start, end, dude_t[i]);
+            info.hit(hit_position, ViewRayTarget::DUDE);
+        }
+    }
+}
+
+void Bullet::update(World &world) {
+    Vector2 step = Vector2Scale(this->velocity, world.timestep);
+    this->prev_position = this->curr_position;
+    this->curr_position = Vector2Add(this->curr_position, step);
+
+    // the bullet stops at whatever it hits first: an obstacle or a dude
+    float obstacle_t = world.get_line_obstacles_intersection_t(
+        this->prev_position, this->curr_position
+    );
+
+    Dude *owner = world.dudes.get(this->owner);
+    float dude_t;
+    int dude_id = world.get_line_bodies_intersection_nearest(
+        this->prev_position, this->curr_position, owner ? owner->body_idx : -1, &dude_t
+    );
+
+    if (dude_id != -1 && dude_t < obstacle_t) {
+        DudeBodies &bodies = world.dude_bodies;
+        bodies.health[dude_id] -= this->damage;
+        bodies.dudes[dude_id]->health = bodies.health[dude_id];
+        if (bodies.health[dude_id] <= 0.0) bodies.radius[dude_id] = 0.0;
+        world.kill_bullet(*this);
+    } else if (obstacle_t <= 1.0) {
+        world.kill_bullet(*this);
+    }
+}
@@ -0,0 +1,966 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "aabb_tree.hpp"
+#include "bvh.hpp"
+#include "geometry.hpp"
+#include "grid.hpp"
+#include "list.hpp"
+#include "ring_buffer.hpp"
+#include "sdf.hpp"
+#include "sort_and_sweep.hpp"
+#include "thread_pool.hpp"
+#include "visibility.hpp"
+
+#define WORLD_TIMESTEP (1.0 / 60.0)
+#define MAX_N_DUDES 16
+#define MAX_N_OBSTACLES 256
+#define DEFAULT_BULLET_TTL 2.0
+#define DEFAULT_BULLET_SPEED 50.0
+#define DEFAULT_BULLET_DAMAGE 1.0
+#define DEFAULT_DUDE_RADIUS 1.0
+#define DEFAULT_DUDE_MAX_HEALTH 5.0
+#define DEFAULT_DUDE_MOVE_SPEED 10.0
+#define DEFAULT_DUDE_FIRE_RATE 5.0
+#define DEFAULT_DUDE_VIEW_DISTANCE 10.0
+#define DEFAULT_DUDE_VIEW_ANGLE (DEG2RAD * 75.0)
+#define DEFAULT_DUDE_N_VIEW_RAYS 32
+#define GRID_CELL_SIZE 4.0
+#define GRID_N_BUCKETS 1024
+#define DUDES_BROADPHASE_MARGIN 0.5
+#define DUDES_TREE_FAT_MARGIN 1.0
+#define MAX_N_BODIES_PAIRS (MAX_N_DUDES * (MAX_N_DUDES - 1) / 2)
+#define OCCUPANCY_GRID_CELL_SIZE 1.0
+#define OCCUPANCY_GRID_MAX_N_CELLS (1 << 18)
+#define SDF_CELL_SIZE 0.25
+#define SDF_MAX_N_NODES (1 << 20)
+#define SDF_PADDING 2.0f
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325
+
+class World;
+
+// FNV-1a of the bytes, continued from the given hash
+uint64_t hash_bytes(uint64_t hash, const void *bytes, size_t n);
+
+enum class AIType {
+    NONE,
+    MANUAL,
+    DUMMY,
+};
+
+enum class ViewRayTarget {
+    NONE,
+    DUDE,
+    OBSTACLE,
+};
+
+// How view rays find their obstacle hits. BVH tests the rays in batches against
+// the obstacles around the dude, OCCUPANCY_GRID walks the grid cells along
+// each ray and stops at the first hit, which is cheaper on big tiled maps.
+// SDF sphere traces the baked distance field: its cost doesn't depend on the
+// obstacle count, but the hits are approximate near the obstacle corners.
+// VISIBILITY_POLYGON sweeps the obstacle edges around the dude once, then every
+// ray costs a single line intersection, which pays off for hundreds of rays.
+enum class SensingBackend {
+    BVH,
+    OCCUPANCY_GRID,
+    SDF,
+    VISIBILITY_POLYGON,
+};
+
+// How dudes are pushed out of obstacles: EXACT resolves every nearby obstacle,
+// SDF steps along the gradient of the baked distance field
+enum class CollisionBackend {
+    EXACT,
+    SDF,
+};
+
+// How the dudes find each other. GRID is rebuilt from scratch every tick,
+// AABB_TREE reinserts only the dudes which have left their fat boxes, and
+// SORT_AND_SWEEP keeps the dudes sorted by x, which is the cheapest for crowds
+// spread mostly along x.
+enum class DudesBroadphase {
+    GRID,
+    AABB_TREE,
+    SORT_AND_SWEEP,
+};
+
+class ViewRayInfo {
+  public:
+    Vector2 origin;
+    Vector2 end_point;
+    ViewRayTarget target = ViewRayTarget::NONE;
+    float dist = FLT_MAX;
+
+    ViewRayInfo() = default;
+
+    void reset(Vector2 origin, Vector2 end_point) {
+        this->origin = origin;
+        this->end_point = end_point;
+        this->dist = FLT_MAX;
+        this->target = ViewRayTarget::NONE;
+    }
+
+    void hit(Vector2 hit_position, ViewRayTarget target) {
+        float dist = Vector2Distance(hit_position, this->origin);
+        if (this->target == ViewRayTarget::NONE || dist < this->dist) {
+            this->end_point = hit_position;
+            this->dist = dist;
+            this->target = target;
+        }
+    }
+};
+
+// What a dude does during the next tick. Manual dudes get their actions from
+// outside (input, replays, agents), the others compute them on their own.
+class DudeAction {
+  public:
+    // Moves with the full speed if the length is 1 or longer
+    Vector2 move_dir = {0.0, 0.0};
+    float orientation = 0.0;
+    bool is_shooting = false;
+};
+
+class Dude {
+  public:
+    AIType ai_type;
+    float body_radius = DEFAULT_DUDE_RADIUS;
+    float max_health = DEFAULT_DUDE_MAX_HEALTH;
+    float move_speed = DEFAULT_DUDE_MOVE_SPEED;
+    float fire_rate = DEFAULT_DUDE_FIRE_RATE;
+
+    float view_distance = DEFAULT_DUDE_VIEW_DISTANCE;
+    float view_angle = DEFAULT_DUDE_VIEW_ANGLE;
+    int n_view_rays = DEFAULT_DUDE_N_VIEW_RAYS;
+
+    Vector2 position;
+    float orientation = 0.0;
+    float health = 0.0;
+    float last_shot_time = -FLT_MAX;
+    DudeAction action;
+
+    // Index of the dude in World::dude_bodies for the current tick, -1 if the
+    // dude is dead and is not a body anymore
+    int body_idx = -1;
+    // Proxy of the dude in World::dudes_tree, -1 if the dude is not in the tree
+    int proxy = -1;
+
+    Dude() = default;
+
+    Dude(Vector2 position, AIType ai_type) {
+        this->ai_type = ai_type;
+        this->position = position;
+        this->health = this->max_health;
+    };
+
+    void update(World &world);
+    void apply_action(World &world, DudeAction action);
+    void update_view(World &world);
+    template <int N> void update_view_rays(World &world);
+};
+
+// Hot dude fields laid out as separate contiguous arrays. They are gathered
+// once per tick, so the collision and bullet hit loops stream only positions,
+// radii and health instead of whole Dude objects. Dead dudes are not gathered,
+// and a dude killed later in the tick gets a zero radius, so it can't be hit.
+// The bodies are double buffered: the passes of World::update read the
+// positions of the previous pass from x, y and write their own results to
+// next_x, next_y, which are swapped in between. So every body of a pass can be
+// updated on any thread, and the tick comes out the same.
+class DudeBodies {
+  public:
+    int n = 0;
+    Dude *dudes[MAX_N_DUDES];
+    float x[MAX_N_DUDES];
+    float y[MAX_N_DUDES];
+    float next_x[MAX_N_DUDES];
+    float next_y[MAX_N_DUDES];
+    float radius[MAX_N_DUDES];
+    float health[MAX_N_DUDES];
+    bool is_shooting[MAX_N_DUDES];
+
+    void gather(SparseList<Dude, MAX_N_DUDES> &list) {
+        this->n = 0;
+        for (Dude &dude : list) {
+            dude.body_idx = -1;
+            if (dude.health <= 0.0) continue;
+
+            int i = this->n++;
+            dude.body_idx = i;
+            this->dudes[i] = &dude;
+            this->x[i] = dude.position.x;
+            this->y[i] = dude.position.y;
+            this->radius[i] = dude.body_radius;
+            this->health[i] = dude.health;
+            this->is_shooting[i] = false;
+        }
+    }
+
+    Vector2 get_position(int i) {
+        return {this->x[i], this->y[i]};
+    }
+
+    void set_next_position(int i, Vector2 position) {
+        this->next_x[i] = position.x;
+        this->next_y[i] = position.y;
+    }
+
+    void swap_positions() {
+        std::swap(this->x, this->next_x);
+        std::swap(this->y, this->next_y);
+    }
+};
+
+// Dude bodies near some area, packed for the batched kernels
+class BodiesSubset {
+  public:
+    int n = 0;
+    int ids[MAX_N_DUDES];
+    float x[MAX_N_DUDES];
+    float y[MAX_N_DUDES];
+    float radius[MAX_N_DUDES];
+};
+
+class Bullet {
+  public:
+    Vector2 prev_position;
+    Vector2 curr_position;
+    Vector2 velocity;
+    Handle owner;
+    float spawn_time = 0.0;
+    float damage = DEFAULT_BULLET_DAMAGE;
+
+    Bullet() = default;
+
+    Bullet(Vector2 position, Vector2 velocity, Handle owner) {
+        this->prev_position = position;
+        this->curr_position = position;
+        this->velocity = velocity;
+        this->owner = owner;
+    };
+
+    void update(World &world);
+};
+
+class Obstacle {
+  public:
+    // Axis aligned boxes go through the rect routines, other obstacles are
+    // convex polygons baked once into a ConvexShape
+    bool is_rect = true;
+    Rectangle rect;
+    ConvexShape shape;
+
+    Obstacle(){};
+    Obstacle(Rectangle rect) {
+        this->rect = rect;
+    }
+    Obstacle(Vector2 vertices[], int n) {
+        this->is_rect = false;
+        this->shape = get_convex_shape(vertices, n);
+        this->rect = this->shape.aabb;
+    }
+};
+
+// Obstacles near some area, packed for the batched kernels
+class ObstaclesSubset {
+  public:
+    int n_rects = 0;
+    int n_shapes = 0;
+    Rectangle rects[MAX_N_OBSTACLES];
+    ConvexShape *shapes[MAX_N_OBSTACLES];
+};
+
+// Everything World::update changes, so a world can be forked and rewound
+// without respawning it. The dude list is copied as a flat blob, and bullets
+// refer to their owners only by handles, so there are no pointers to fix.
+// The bullet ring reuses its chunks, the broadphase containers and the view
+// rays reuse their vectors, so taking a snapshot into the same object again
+// doesn't allocate.
+// Obstacles never move, they're shared with the world the snapshot came from.
+// They and the world settings are only checked on restore.
+class WorldSnapshot {
+  public:
+    float time = 0.0;
+    float timestep = 0.0;
+    float bullet_ttl = 0.0;
+    SensingBackend sensing_backend;
+    CollisionBackend collision_backend;
+    DudesBroadphase dudes_broadphase;
+    SparseList<Dude, MAX_N_DUDES> dudes;
+    RingBuffer<Bullet> bullets;
+    DynamicAABBTree dudes_tree = DynamicAABBTree(DUDES_TREE_FAT_MARGIN);
+    SortAndSweep dudes_sweep;
+    std::vector<ViewRayInfo> view_ray_infos;
+    uint32_t view_ray_offsets[MAX_N_DUDES];
+    uint32_t view_ray_capacities[MAX_N_DUDES];
+    uint64_t obstacles_hash = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<SparseList<Dude, MAX_N_DUDES>>);
+static_assert(std::is_trivially_copyable_v<Bullet>);
+static_assert(std::is_trivially_copyable_v<ViewRayInfo>);
+
+class World {
+  public:
+    float timestep = WORLD_TIMESTEP;
+    float time = 0.0;
+
+    SparseList<Dude, MAX_N_DUDES> dudes;
+    float bullet_ttl = DEFAULT_BULLET_TTL;
+
+    // All bullets live for the same time, so they expire in the spawn order:
+    // the oldest ones are always at the front of the ring.
+    RingBuffer<Bullet> bullets;
+    SparseList<Obstacle, MAX_N_OBSTACLES> obstacles;
+
+    // Obstacles never move, their geometry is packed once at spawn for the
+    // batched intersection kernels
+    Rectangle obstacle_rects[MAX_N_OBSTACLES];
+    int n_obstacle_rects = 0;
+    ConvexShape obstacle_shapes[MAX_N_OBSTACLES];
+    int n_obstacle_shapes = 0;
+
+    DudeBodies dude_bodies;
+
+    // Obstacles never move, so their BVH and occupancy grid are built once by
+    // finish_level() (shapes with ids offset by MAX_N_OBSTACLES). Dudes are
+    // reinserted into the grid every tick, or moved in the tree.
+    SensingBackend sensing_backend = SensingBackend::BVH;
+    BVH obstacles_bvh;
+    OccupancyGrid obstacles_occupancy_grid;
+    bool is_obstacles_broadphase_dirty = false;
+    // Hash of the obstacles geometry, taken with the broadphase, so snapshots
+    // are restored only into a world with the same obstacles
+    uint64_t obstacles_hash = 0;
+
+    // The distance field is expensive to bake, so it's baked once by
+    // finish_level() after the obstacles have been spawned, not by update()
+    CollisionBackend collision_backend = CollisionBackend::EXACT;
+    SDF obstacles_sdf;
+    bool is_obstacles_sdf_dirty = true;
+
+    DudesBroadphase dudes_broadphase = DudesBroadphase::AABB_TREE;
+    SpatialGrid dudes_grid = SpatialGrid(GRID_CELL_SIZE, GRID_N_BUCKETS);
+    DynamicAABBTree dudes_tree = DynamicAABBTree(DUDES_TREE_FAT_MARGIN);
+    SortAndSweep dudes_sweep;
+
+    // View ray results are kept apart from the Dude objects, so they don't
+    // bloat the dudes iterated by every other loop. Every dude slot owns a
+    // range of the shared buffer sized by its n_view_rays, so a few dudes with
+    // hundreds of rays don't make every slot (and every snapshot) that big.
+    std::vector<ViewRayInfo> view_ray_infos;
+    uint32_t view_ray_offsets[MAX_N_DUDES] = {};
+    uint32_t view_ray_capacities[MAX_N_DUDES] = {};
+
+    // Scratch visibility polygons (also by the dude slot), reset every tick,
+    // so their buffers are allocated once and not per dude per tick
+    VisibilityPolygon view_visibilities[MAX_N_DUDES];
+
+    // Dudes killed during the current tick. They stay in the list until the end
+    // of update(), so nothing is removed in the middle of an iteration.
+    // Killed bullets are only marked dead in the ring, which is already safe.
+    std::array<Handle, MAX_N_DUDES> killed_dudes;
+    uint32_t n_killed_dudes = 0;
+
+    // Colliding bodies pairs of the current tick
+    std::array<std::array<int, 2>, MAX_N_BODIES_PAIRS> bodies_pairs;
+    int n_bodies_pairs = 0;
+
+    // Optional pool (not owned) which spreads the per dude passes of update()
+    // over threads. The world is updated the same way with or without it.
+    // ThreadPool::run is not reentrant, so this must not be the pool of a
+    // WorldBatch which updates this world: that deadlocks.
+    ThreadPool *pool = nullptr;
+
+    World(){};
+    ~World(){};
+
+    void update() {
+        if (this->is_obstacles_broadphase_dirty) {
+            throw std::runtime_error("ERROR: Obstacles broadphase is not built");
+        }
+        if (this->is_obstacles_sdf_used() && this->is_obstacles_sdf_dirty) {
+            throw std::runtime_error("ERROR: Obstacles SDF is not baked");
+        }
+        this->time += this->timestep;
+
+        DudeBodies &bodies = this->dude_bodies;
+        for (Dude &dude : this->dudes) {
+            if (dude.health <= 0.0) this->kill_dude(dude);
+            this->reserve_view_ray_infos(dude);
+        }
+        bodies.gather(this->dudes);
+        this->update_dudes_broadphase();
+
+        // ---------------------------------------------------------------
+        // move: every dude acts and is pushed out of the obstacles
+        this->parallel_for(bodies.n, [&](int i) { bodies.dudes[i]->update(*this); });
+        bodies.swap_positions();
+
+        this->resolve_dudes_collisions();
+        this->spawn_bodies_bullets();
+
+        // ---------------------------------------------------------------
+        // sense: the bodies are only read from here on
+        this->parallel_for(bodies.n, [&](int i) {
+            bodies.dudes[i]->update_view(*this);
+        });
+
+        this->expire_bullets();
+        for (Bullet &bullet : this->bullets) {
+            bullet.update(*this);
+        }
+
+        this->remove_killed();
+    }
+
+    // Bodies are inserted with a margin, so the broadphase stays valid while
+    // the dudes move during the tick
+    void update_dudes_broadphase() {
+        switch (this->dudes_broadphase) {
+            case DudesBroadphase::GRID: this->update_dudes_grid(); break;
+            case DudesBroadphase::AABB_TREE: this->update_dudes_tree(); break;
+            case DudesBroadphase::SORT_AND_SWEEP: this->update_dudes_sweep(); break;
+        }
+    }
+
+    void update_dudes_grid() {
+        DudeBodies &bodies = this->dude_bodies;
+        this->dudes_grid.clear();
+        for (int i = 0; i < bodies.n; ++i) {
+            Rectangle aabb = get_circle_aabb(
+                bodies.get_position(i), bodies.radius[i] + DUDES_BROADPHASE_MARGIN
+            );
+            this->dudes_grid.insert(i, aabb);
+        }
+        this->dudes_grid.build();
+    }
+
+    // The tree items are body ids, which change whenever some dude dies, so
+    // the ids are rewritten every tick, but the tree is touched only by the
+    // dudes which have left their fat boxes
+    void update_dudes_tree() {
+        for (Dude &dude : this->dudes) {
+            if (dude.body_idx == -1) {
+                this->destroy_dude_proxy(dude);
+                continue;
+            }
+
+            Rectangle aabb = get_circle_aabb(
+                dude.position, dude.body_radius + DUDES_BROADPHASE_MARGIN
+            );
+            if (dude.proxy == -1) {
+                dude.proxy = this->dudes_tree.create_proxy(dude.body_idx, aabb);
+            } else {
+                this->dudes_tree.set_proxy_id(dude.proxy, dude.body_idx);
+                this->dudes_tree.move_proxy(dude.proxy, aabb);
+            }
+        }
+    }
+
+    // The sweep items are keyed by the dude slots, so a dude keeps its place
+    // in the sorted order between ticks
+    void update_dudes_sweep() {
+        DudeBodies &bodies = this->dude_bodies;
+        for (int i = 0; i < bodies.n; ++i) {
+            Rectangle aabb = get_circle_aabb(
+                bodies.get_position(i), bodies.radius[i] + DUDES_BROADPHASE_MARGIN
+            );
+            int key = this->dudes.get_handle(*bodies.dudes[i]).index;
+            this->dudes_sweep.set(key, i, aabb);
+        }
+        this->dudes_sweep.sort();
+    }
+
+    void destroy_dude_proxy(Dude &dude) {
+        if (dude.proxy == -1) return;
+        this->dudes_tree.destroy_proxy(dude.proxy);
+        dude.proxy = -1;
+    }
+
+    void query_bodies(Rectangle area, int skip_id, BodiesSubset *subset) {
+        DudeBodies &bodies = this->dude_bodies;
+        int ids[MAX_N_DUDES];
+        int n = 0;
+        switch (this->dudes_broadphase) {
+            case DudesBroadphase::GRID: {
+                n = this->dudes_grid.query(area, ids, MAX_N_DUDES);
+                break;
+            }
+            case DudesBroadphase::AABB_TREE: {
+                n = this->dudes_tree.query(area, ids, MAX_N_DUDES);
+                break;
+            }
+            case DudesBroadphase::SORT_AND_SWEEP: {
+                n = this->dudes_sweep.query(area, ids, MAX_N_DUDES);
+                break;
+            }
+        }
+
+        subset->n = 0;
+        for (int i = 0; i < n; ++i) {
+            int id = ids[i];
+            if (id == skip_id) continue;
+
+            int j = subset->n++;
+            subset->ids[j] = id;
+            subset->x[j] = bodies.x[id];
+            subset->y[j] = bodies.y[id];
+            subset->radius[j] = bodies.radius[id];
+        }
+    }
+
+    // Calls on_pair(id_a, id_b) once for every pair of bodies which may overlap
+    template <typename OnPair> void query_bodies_pairs(OnPair on_pair) {
+        switch (this->dudes_broadphase) {
+            case DudesBroadphase::GRID: {
+                DudeBodies &bodies = this->dude_bodies;
+                int ids[MAX_N_DUDES];
+                for (int i = 0; i < bodies.n; ++i) {
+                    float radius = bodies.radius[i] + DUDES_BROADPHASE_MARGIN;
+                    Rectangle aabb = get_circle_aabb(bodies.get_position(i), radius);
+                    int n = this->dudes_grid.query(aabb, ids, MAX_N_DUDES);
+                    for (int j = 0; j < n; ++j) {
+                        if (ids[j] > i) on_pair(i, ids[j]);
+                    }
+                }
+                break;
+            }
+            case DudesBroadphase::AABB_TREE: {
+                this->dudes_tree.query_pairs(on_pair);
+                break;
+            }
+            case DudesBroadphase::SORT_AND_SWEEP: {
+                this->dudes_sweep.query_pairs(on_pair);
+                break;
+            }
+        }
+    }
+
+    // Every overlapping pair is resolved once: both bodies are pushed apart by
+    // half of the overlap. Bodies killed during the tick don't push anyone.
+    // Every pair is pushed apart from the positions after the move, and the
+    // pushes are summed in the pair order. There are at most a few hundred
+    // cheap pairs, so they're not worth a dispatch to the pool.
+    void resolve_dudes_collisions() {
+        DudeBodies &bodies = this->dude_bodies;
+        this->n_bodies_pairs = 0;
+        this->query_bodies_pairs([&](int i, int j) {
+            if (bodies.radius[i] <= 0.0 || bodies.radius[j] <= 0.0) return;
+            if (this->n_bodies_pairs == MAX_N_BODIES_PAIRS) return;
+            this->bodies_pairs[this->n_bodies_pairs++] = {i, j};
+        });
+
+        for (int i = 0; i < bodies.n; ++i) {
+            bodies.set_next_position(i, bodies.get_position(i));
+        }
+        for (int k = 0; k < this->n_bodies_pairs; ++k) {
+            auto [i, j] = this->bodies_pairs[k];
+            Vector2 mtv = get_circle_circle_mtv(
+                bodies.get_position(i),
+                bodies.radius[i],
+                bodies.get_position(j),
+                bodies.radius[j]
+            );
+            mtv = Vector2Scale(mtv, 0.5);
+            bodies.next_x[i] += mtv.x;
+            bodies.next_y[i] += mtv.y;
+            bodies.next_x[j] -= mtv.x;
+            bodies.next_y[j] -= mtv.y;
+        }
+        bodies.swap_positions();
+
+        for (int i = 0; i < bodies.n; ++i) {
+            bodies.dudes[i]->position = bodies.get_position(i);
+        }
+    }
+
+    // Dudes only request their shots during the move, the bullets are spawned
+    // afterwards in the bodies order, from the resolved positions
+    void spawn_bodies_bullets() {
+        DudeBodies &bodies = this->dude_bodies;
+        for (int i = 0; i < bodies.n; ++i) {
+            if (!bodies.is_shooting[i]) continue;
+
+            Dude &dude = *bodies.dudes[i];
+            Vector2 bullet_velocity = Vector2Scale(
+                get_orientation_vec(dude.orientation), DEFAULT_BULLET_SPEED
+            );
+            this->spawn_bullet(
+                {dude.position, bullet_velocity, this->dudes.get_handle(dude)}
+            );
+        }
+    }
+
+    // Calls fn(i) for every i in [0, n), split into equal static chunks over
+    // the pool threads if the world has a pool of more than one thread. fn
+    // must write only to the outputs of its own i.
+    template <typename Fn> void parallel_for(int n, Fn fn) {
+        int n_threads = this->pool ? this->pool->get_n_threads() : 1;
+        if (n_threads == 1 || n < 2) {
+            for (int i = 0; i < n; ++i) fn(i);
+            return;
+        }
+
+        this->pool->run([&](int thread_idx) {
+            int begin = n * thread_idx / n_threads;
+            int end = n * (thread_idx + 1) / n_threads;
+            for (int i = begin; i < end; ++i) fn(i);
+        });
+    }
+
+    // Returns the id of the nearest body hit by the line and writes its hit t,
+    // -1 if no body is hit
+    int get_line_bodies_intersection_nearest(
+        Vector2 start, Vector2 end, int skip_id, float *t
+    ) {
+        DudeBodies &bodies = this->dude_bodies;
+        if (this->dudes_broadphase != DudesBroadphase::AABB_TREE) {
+            BodiesSubset nearby;
+            this->query_bodies(get_line_aabb(start, end), skip_id, &nearby);
+            int nearby_id = get_line_circles_intersection_nearest(
+                start, end, nearby.x, nearby.y, nearby.radius, nearby.n, -1, t
+            );
+            return nearby_id == -1 ? -1 : nearby.ids[nearby_id];
+        }
+
+        int nearest_id = -1;
+        float nearest_t = FLT_MAX;
+        this->dudes_tree.cast_line(start, end, [&](int id) {
+            float curr_t;
+            if (id == skip_id) return FLT_MAX;
+
+            int hit_id = get_line_circles_intersection_nearest(
+                start,
+                end,
+                &bodies.x[id],
+                &bodies.y[id],
+                &bodies.radius[id],
+                1,
+                -1,
+                &curr_t
+            );
+            if (hit_id == -1) return FLT_MAX;
+            if (curr_t < nearest_t) {
+                nearest_id = id;
+                nearest_t = curr_t;
+            }
+            return curr_t;
+        });
+        *t = nearest_t;
+        return nearest_id;
+    }
+
+    void query_obstacles(Rectangle area, ObstaclesSubset *subset) {
+        int ids[2 * MAX_N_OBSTACLES];
+        int n = this->obstacles_bvh.query(area, ids, 2 * MAX_N_OBSTACLES);
+
+        subset->n_rects = 0;
+        subset->n_shapes = 0;
+        for (int i = 0; i < n; ++i) {
+            int id = ids[i];
+            if (id < MAX_N_OBSTACLES) {
+                subset->rects[subset->n_rects++] = this->obstacle_rects[id];
+            } else {
+                ConvexShape *shape = &this->obstacle_shapes[id - MAX_N_OBSTACLES];
+                subset->shapes[subset->n_shapes++] = shape;
+            }
+        }
+    }
+
+    float get_line_obstacle_intersection_t(int id, Vector2 start, Vector2 end) {
+        if (id < MAX_N_OBSTACLES) {
+            Rectangle *rect = &this->obstacle_rects[id];
+            return get_line_rects_intersection_t(start, end, rect, 1);
+        }
+        ConvexShape *shape = &this->obstacle_shapes[id - MAX_N_OBSTACLES];
+        return get_line_convex_shape_intersection_t(start, end, shape);
+    }
+
+    float get_line_obstacles_intersection_t(Vector2 start, Vector2 end) {
+        return this->obstacles_bvh.cast_line(start, end, [&](int id) {
+            return this->get_line_obstacle_intersection_t(id, start, end);
+        });
+    }
+
+    void get_visibility_polygon(
+        Vector2 origin,
+        float radius,
+        float orientation,
+        float span_angle,
+        VisibilityPolygon *visibility
+    ) {
+        visibility->reset(origin, radius, orientation, span_angle);
+
+        ObstaclesSubset obstacles;
+        this->query_obstacles(get_circle_aabb(origin, radius), &obstacles);
+        for (int i = 0; i < obstacles.n_rects; ++i) {
+            Rectangle rect = obstacles.rects[i];
+            Vector2 p00 = {rect.x, rect.y};
+            Vector2 p10 = {rect.x + rect.width, rect.y};
+            Vector2 p11 = {rect.x + rect.width, rect.y + rect.height};
+            Vector2 p01 = {rect.x, rect.y + rect.height};
+            visibility->add_edge(p00, p10, {0.0, -1.0});
+            visibility->add_edge(p10, p11, {1.0, 0.0});
+            visibility->add_edge(p11, p01, {0.0, 1.0});
+            visibility->add_edge(p01, p00, {-1.0, 0.0});
+        }
+        for (int i = 0; i < obstacles.n_shapes; ++i) {
+            ConvexShape *shape = obstacles.shapes[i];
+            for (int j = 0; j < shape->n; ++j) {
+                Vector2 start = shape->vertices[j];
+                Vector2 end = shape->vertices[(j + 1) % shape->n];
+                visibility->add_edge(start, end, shape->normals[j]);
+            }
+        }
+
+        visibility->build();
+    }
+
+    void kill_dude(Dude &dude) {
+        this->killed_dudes[this->n_killed_dudes++] = this->dudes.get_handle(dude);
+    }
+
+    void kill_bullet(Bullet &bullet) {
+        this->bullets.remove(bullet);
+    }
+
+    void expire_bullets() {
+        while (!this->bullets.empty()
+               && this->time - this->bullets.front().spawn_time >= this->bullet_ttl) {
+            this->bullets.pop_front();
+        }
+    }
+
+    // Snapshots can be taken and restored only between the updates
+    void take_snapshot(WorldSnapshot &snapshot) {
+        snapshot.time = this->time;
+        snapshot.timestep = this->timestep;
+        snapshot.bullet_ttl = this->bullet_ttl;
+        snapshot.sensing_backend = this->sensing_backend;
+        snapshot.collision_backend = this->collision_backend;
+        snapshot.dudes_broadphase = this->dudes_broadphase;
+        snapshot.dudes = this->dudes;
+        snapshot.bullets = this->bullets;
+        snapshot.dudes_tree = this->dudes_tree;
+        snapshot.dudes_sweep = this->dudes_sweep;
+        snapshot.view_ray_infos = this->view_ray_infos;
+        std::copy(
+            std::begin(this->view_ray_offsets),
+            std::end(this->view_ray_offsets),
+            std::begin(snapshot.view_ray_offsets)
+        );
+        std::copy(
+            std::begin(this->view_ray_capacities),
+            std::end(this->view_ray_capacities),
+            std::begin(snapshot.view_ray_capacities)
+        );
+        snapshot.obstacles_hash = this->obstacles_hash;
+    }
+
+    void restore_snapshot(const WorldSnapshot &snapshot) {
+        if (snapshot.obstacles_hash != this->obstacles_hash) {
+            throw std::runtime_error(
+                "ERROR: Snapshot is from a world with other obstacles"
+            );
+        }
+        bool is_same_settings = snapshot.timestep == this->timestep
+                                && snapshot.bullet_ttl == this->bullet_ttl
+                                && snapshot.sensing_backend == this->sensing_backend
+                                && snapshot.collision_backend == this->collision_backend
+                                && snapshot.dudes_broadphase == this->dudes_broadphase;
+        if (!is_same_settings) {
+            throw std::runtime_error(
+                "ERROR: Snapshot is from a world with other settings"
+            );
+        }
+
+        this->time = snapshot.time;
+        this->dudes = snapshot.dudes;
+        this->bullets = snapshot.bullets;
+        this->dudes_tree = snapshot.dudes_tree;
+        this->dudes_sweep = snapshot.dudes_sweep;
+        this->view_ray_infos = snapshot.view_ray_infos;
+        std::copy(
+            std::begin(snapshot.view_ray_offsets),
+            std::end(snapshot.view_ray_offsets),
+            std::begin(this->view_ray_offsets)
+        );
+        std::copy(
+            std::begin(snapshot.view_ray_capacities),
+            std::end(snapshot.view_ray_capacities),
+            std::begin(this->view_ray_capacities)
+        );
+        this->n_killed_dudes = 0;
+
+        // the bodies point into the dudes list, so they're gathered again
+        this->dude_bodies.gather(this->dudes);
+    }
+
+    // Gives the dude slot room for all the dude view rays. It's called from
+    // the serial part of update(), so the sense pass only writes into the
+    // ranges which already exist. A slot which needs more rays gets a new
+    // range at the end, the old one is left unused.
+    void reserve_view_ray_infos(Dude &dude) {
+        uint32_t slot = this->dudes.get_handle(dude).index;
+        uint32_t n = std::clamp(dude.n_view_rays, 0, MAX_N_RAYS_IN_RAYS_FAN);
+        if (this->view_ray_capacities[slot] >= n) return;
+
+        this->view_ray_offsets[slot] = this->view_ray_infos.size();
+        this->view_ray_capacities[slot] = n;
+        this->view_ray_infos.resize(this->view_ray_infos.size() + n);
+    }
+
+    ViewRayInfo *get_view_ray_infos(Dude &dude) {
+        uint32_t slot = this->dudes.get_handle(dude).index;
+        return this->view_ray_infos.data() + this->view_ray_offsets[slot];
+    }
+
+    // Number of the dude view rays which have room for their results
+    int get_n_view_ray_infos(Dude &dude) {
+        uint32_t slot = this->dudes.get_handle(dude).index;
+        return std::min<int>(dude.n_view_rays, this->view_ray_capacities[slot]);
+    }
+
+    VisibilityPolygon *get_view_visibility(Dude &dude) {
+        return &this->view_visibilities[this->dudes.get_handle(dude).index];
+    }
+
+    void remove_killed() {
+        for (uint32_t i = 0; i < this->n_killed_dudes; ++i) {
+            Dude *dude = this->dudes.get(this->killed_dudes[i]);
+            if (!dude) continue;
+
+            this->destroy_dude_proxy(*dude);
+            this->dudes.remove(*dude);
+        }
+
+        this->n_killed_dudes = 0;
+    }
+
+    void spawn_dude(Dude dude) {
+        if (!this->dudes.insert(dude)) {
+            throw std::runtime_error("ERROR: Can't spawn more dudes");
+        }
+    }
+
+    void spawn_bullet(Bullet bullet) {
+        bullet.spawn_time = this->time;
+        this->bullets.push_back(bullet);
+    }
+
+    void spawn_obstacle(Obstacle obstacle) {
+        if (!this->obstacles.insert(obstacle)) {
+            throw std::runtime_error("ERROR: Can't spawn more obstacles");
+        }
+
+        if (obstacle.is_rect) {
+            this->obstacle_rects[this->n_obstacle_rects++] = obstacle.rect;
+        } else {
+            this->obstacle_shapes[this->n_obstacle_shapes++] = obstacle.shape;
+        }
+        this->is_obstacles_broadphase_dirty = true;
+        this->is_obstacles_sdf_dirty = true;
+    }
+
+    void build_obstacles_broadphase() {
+        Rectangle boxes[2 * MAX_N_OBSTACLES];
+        int ids[2 * MAX_N_OBSTACLES];
+        int n = 0;
+        for (int i = 0; i < this->n_obstacle_rects; ++i) {
+            boxes[n] = this->obstacle_rects[i];
+            ids[n++] = i;
+        }
+        for (int i = 0; i < this->n_obstacle_shapes; ++i) {
+            boxes[n] = this->obstacle_shapes[i].aabb;
+            ids[n++] = MAX_N_OBSTACLES + i;
+        }
+        this->obstacles_bvh.build(boxes, ids, n);
+        this->obstacles_occupancy_grid.build(
+            boxes, ids, n, OCCUPANCY_GRID_CELL_SIZE, OCCUPANCY_GRID_MAX_N_CELLS
+        );
+        this->obstacles_hash = this->get_obstacles_hash();
+        this->is_obstacles_broadphase_dirty = false;
+    }
+
+    uint64_t get_obstacles_hash() {
+        uint64_t hash = FNV_OFFSET_BASIS;
+        for (int i = 0; i < this->n_obstacle_rects; ++i) {
+            Rectangle rect = this->obstacle_rects[i];
+            hash = hash_bytes(hash, &rect, sizeof(rect));
+        }
+        for (int i = 0; i < this->n_obstacle_shapes; ++i) {
+            ConvexShape &shape = this->obstacle_shapes[i];
+            hash = hash_bytes(hash, &shape.n, sizeof(shape.n));
+            hash = hash_bytes(hash, shape.vertices, shape.n * sizeof(Vector2));
+        }
+        return hash;
+    }
+
+    // Called once the level is set up: the obstacles are spawned and the
+    // backends are chosen. Bakes everything which is too slow for a tick.
+    void finish_level() {
+        if (this->is_obstacles_broadphase_dirty) {
+            this->build_obstacles_broadphase();
+        }
+        if (this->is_obstacles_sdf_used() && this->is_obstacles_sdf_dirty) {
+            this->bake_obstacles_sdf();
+        }
+    }
+
+    bool is_obstacles_sdf_used() {
+        return this->sensing_backend == SensingBackend::SDF
+               || this->collision_backend == CollisionBackend::SDF;
+    }
+
+    void bake_obstacles_sdf() {
+        Vector2 min = {FLT_MAX, FLT_MAX};
+        Vector2 max = {-FLT_MAX, -FLT_MAX};
+        for (int i = 0; i < this->n_obstacle_rects; ++i) {
+            Rectangle rect = this->obstacle_rects[i];
+            min = Vector2Min(min, {rect.x, rect.y});
+            max = Vector2Max(max, {rect.x + rect.width, rect.y + rect.height});
+        }
+        for (int i = 0; i < this->n_obstacle_shapes; ++i) {
+            Rectangle aabb = this->obstacle_shapes[i].aabb;
+            min = Vector2Min(min, {aabb.x, aabb.y});
+            max = Vector2Max(max, {aabb.x + aabb.width, aabb.y + aabb.height});
+        }
+        if (min.x > max.x) min = max = Vector2Zero();
+
+        Rectangle bounds = {
+            min.x - SDF_PADDING,
+            min.y - SDF_PADDING,
+            max.x - min.x + 2.0f * SDF_PADDING,
+            max.y - min.y + 2.0f * SDF_PADDING};
+        auto get_dist = [this](Vector2 p) {
+            return this->get_point_obstacles_signed_dist(p);
+        };
+        this->obstacles_sdf.bake(
+            bounds, SDF_PADDING, SDF_CELL_SIZE, SDF_MAX_N_NODES, get_dist
+        );
+        this->is_obstacles_sdf_dirty = false;
+    }
+
+    float get_point_obstacles_signed_dist(Vector2 point) {
+        float dist = FLT_MAX;
+        for (int i = 0; i < this->n_obstacle_rects; ++i) {
+            Rectangle rect = this->obstacle_rects[i];
+            dist = std::min(dist, get_point_rect_signed_dist(point, rect));
+        }
+        for (int i = 0; i < this->n_obstacle_shapes; ++i) {
+            ConvexShape *shape = &this->obstacle_shapes[i];
+            dist = std::min(dist, get_point_convex_shape_signed_dist(point, shape));
+        }
+        return dist;
+    }
+};
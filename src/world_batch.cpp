@@ -0,0 +1,86 @@
+#include <chrono>
+
+#include "world_batch.hpp"
+
+static uint64_t pack_range(uint32_t begin, uint32_t end) {
+    return ((uint64_t)begin << 32) | end;
+}
+
+void WorldBatch::Chunk::set(uint32_t begin, uint32_t end) {
+    this->range.store(pack_range(begin, end));
+}
+
+bool WorldBatch::Chunk::pop_front(uint32_t *idx) {
+    uint64_t range = this->range.load();
+    while (true) {
+        uint32_t begin = range >> 32;
+        uint32_t end = range & 0xffffffff;
+        if (begin >= end) return false;
+        if (this->range.compare_exchange_weak(range, pack_range(begin + 1, end))) {
+            *idx = begin;
+            return true;
+        }
+    }
+}
+
+bool WorldBatch::Chunk::pop_back(uint32_t *idx) {
+    uint64_t range = this->range.load();
+    while (true) {
+        uint32_t begin = range >> 32;
+        uint32_t end = range & 0xffffffff;
+        if (begin >= end) return false;
+        if (this->range.compare_exchange_weak(range, pack_range(begin, end - 1))) {
+            *idx = end - 1;
+            return true;
+        }
+    }
+}
+
+WorldBatch::WorldBatch(int n_worlds, int n_threads)
+    : pool(n_threads)
+    , chunks(pool.get_n_threads())
+    , worlds(n_worlds) {}
+
+bool WorldBatch::get_next_world(int thread_idx, uint32_t *idx) {
+    if (this->chunks[thread_idx].pop_front(idx)) return true;
+
+    int n_threads = this->chunks.size();
+    for (int i = 1; i < n_threads; ++i) {
+        if (this->chunks[(thread_idx + i) % n_threads].pop_back(idx)) return true;
+    }
+    return false;
+}
+
+void WorldBatch::run(
+    int max_n_ticks,
+    std::function<void(World &)> act,
+    std::function<bool(World &)> is_done
+) {
+    uint32_t n_worlds = this->worlds.size();
+    uint32_t n_threads = this->chunks.size();
+    for (uint32_t i = 0; i < n_threads; ++i) {
+        this->chunks[i].set(i * n_worlds / n_threads, (i + 1) * n_worlds / n_threads);
+    }
+
+    std::atomic<int64_t> n_ticks = 0;
+    auto start = std::chrono::steady_clock::now();
+    this->pool.run([&](int thread_idx) {
+        int64_t n_thread_ticks = 0;
+        uint32_t idx;
+        while (this->get_next_world(thread_idx, &idx)) {
+            World &world = this->worlds[idx];
+            for (int tick = 0; tick < max_n_ticks; ++tick) {
+                if (is_done && is_done(world)) break;
+                if (act) act(world);
+                world.update();
+                ++n_thread_ticks;
+            }
+        }
+        n_ticks += n_thread_ticks;
+    });
+    auto end = std::chrono::steady_clock::now();
+
+    this->n_ticks = n_ticks;
+    this->seconds = std::chrono::duration<double>(end - start).count();
+    this->ticks_per_second = this->n_ticks / this->seconds;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "world.hpp"
+
+// Many independent worlds stepped in parallel. Every thread starts with its
+// own contiguous chunk of worlds and runs their episodes one by one; a thread
+// which has finished its chunk steals the not yet started worlds from the end
+// of the other chunks, so uneven episode lengths don't leave threads idle.
+class WorldBatch {
+  private:
+    // Not started worlds of a thread chunk: [begin, end) packed into one word,
+    // the owner takes from the begin, the thieves from the end
+    class alignas(64) Chunk {
+      public:
+        std::atomic<uint64_t> range;
+
+        void set(uint32_t begin, uint32_t end);
+        bool pop_front(uint32_t *idx);
+        bool pop_back(uint32_t *idx);
+    };
+
+    ThreadPool pool;
+    std::vector<Chunk> chunks;
+
+    bool get_next_world(int thread_idx, uint32_t *idx);
+
+  public:
+    std::vector<World> worlds;
+
+    // Stats of the last run()
+    int64_t n_ticks = 0;
+    double seconds = 0.0;
+    double ticks_per_second = 0.0;
+
+    // 0 threads means one per hardware thread
+    WorldBatch(int n_worlds, int n_threads);
+
+    // Runs every world for max_n_ticks ticks or until is_done(world). The act
+    // callback sets the actions of the manual dudes before every tick. Both
+    // callbacks are called concurrently for different worlds and may be empty.
+    void run(
+        int max_n_ticks,
+        std::function<void(World &)> act,
+        std::function<bool(World &)> is_done
+    );
+};